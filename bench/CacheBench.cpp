@@ -0,0 +1,177 @@
+// Benchmark for the height cache: regenerating LOD0 chunk grids from noise
+// versus reading them back through HeightCodec and the region files.
+// Reports the compression ratio, decode throughput per path, and the
+// speedup of a (page-cache warm) cache read over regeneration, blocking and
+// through CacheIO with each backend.
+//
+//   cache_bench [chunks] [precision]
+
+#include "CacheIO.h"
+#include "HeightCodec.h"
+#include "TerrainCache.h"
+#include "TerrainGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace {
+    template<typename Fn>
+    double bestOf(int reps, Fn&& fn){
+        double best = 1e30;
+        for(int rep = 0; rep < reps; ++rep){
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            auto t1 = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv){
+    const int chunks = (argc > 1) ? std::atoi(argv[1]) : 256;
+    const float precision = (argc > 2) ? float(std::atof(argv[2])) : HeightCodec::DEFAULT_PRECISION;
+    const int cells = HIGH_LOD_CELLS;
+    const float worldScale = 1.0f;
+
+    // Same parameters World uses
+    TerrainGenerator::Params params;
+    params.baseFrequency = 0.004f;
+    params.octaves = 5;
+    params.persistence = 0.48f;
+    params.lacunarity = 2.0f;
+    params.heightScale = 100.0f;
+    params.seed = 42;
+    TerrainGenerator generator(params);
+    TerrainGenerator::SnapshotPtr gen = generator.snapshot();
+
+    auto chunkX = [](int c) { return c % 16 - 8; };
+    auto chunkZ = [](int c) { return c / 16 - 8; };
+
+    std::printf("%d chunks of %dx%d (+apron), precision %g, decode path: %s\n",
+        chunks, cells, cells, precision, HeightCodec::decodePathName());
+
+    // Regenerating from noise is what a cache hit replaces
+    std::vector<HeightGrid> grids(chunks);
+    double generate = bestOf(3, [&]() {
+        for(int c = 0; c < chunks; ++c){
+            grids[c] = gen->generateHeights(chunkX(c), chunkZ(c), cells, worldScale);
+        }
+    });
+
+    std::vector<std::vector<uint8_t>> encoded(chunks);
+    size_t rawBytes = 0, encodedBytes = 0;
+    double encode = bestOf(3, [&]() {
+        rawBytes = encodedBytes = 0;
+        for(int c = 0; c < chunks; ++c){
+            const HeightGrid& g = grids[c];
+            encoded[c].clear();
+            HeightCodec::encode(g.heights.data(), g.stride(), g.stride(), precision, encoded[c]);
+            rawBytes += g.heights.size() * sizeof(float);
+            encodedBytes += encoded[c].size();
+        }
+    });
+
+    // Both decode paths must agree bit for bit and stay within half a step
+    std::vector<std::vector<float>> decodedSimd(chunks), decodedScalar(chunks);
+    for(int c = 0; c < chunks; ++c){
+        decodedSimd[c].resize(grids[c].heights.size());
+        decodedScalar[c].resize(grids[c].heights.size());
+    }
+    double decodeScalar = bestOf(5, [&]() {
+        for(int c = 0; c < chunks; ++c){
+            HeightCodec::decodeScalar(encoded[c].data(), encoded[c].size(), decodedScalar[c].data(), decodedScalar[c].size());
+        }
+    });
+    double decodeSimd = bestOf(5, [&]() {
+        for(int c = 0; c < chunks; ++c){
+            HeightCodec::decode(encoded[c].data(), encoded[c].size(), decodedSimd[c].data(), decodedSimd[c].size());
+        }
+    });
+
+    float maxError = 0.0f;
+    bool identical = true;
+    for(int c = 0; c < chunks; ++c){
+        identical = identical && decodedSimd[c] == decodedScalar[c];
+        for(size_t i = 0; i < grids[c].heights.size(); ++i){
+            maxError = std::max(maxError, std::fabs(decodedSimd[c][i] - grids[c].heights[i]));
+        }
+    }
+
+    // End to end through the region files (warm page cache)
+    const std::string dir = "cache_bench_tmp";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    uint64_t hash = TerrainCache::paramsHash(params, worldScale);
+    double cacheRead;
+    double asyncRead[2] = {0.0, 0.0};
+    const char* backendNames[2] = {"", ""};
+    bool asyncOk = true;
+    {
+        auto cache = std::make_shared<TerrainCache>(dir, precision);
+
+        // Written through CacheIO, as the terrain does
+        {
+            CacheIO io(cache);
+            for(int c = 0; c < chunks; ++c){
+                io.write(hash, chunkX(c), chunkZ(c), grids[c]);
+            }
+        }
+
+        HeightGrid out;
+        cacheRead = bestOf(5, [&]() {
+            for(int c = 0; c < chunks; ++c){
+                if(!cache->loadHeightMap(hash, chunkX(c), chunkZ(c), cells, out)){
+                    std::printf("cache miss at chunk %d\n", c);
+                }
+            }
+        });
+
+        // Every lookup queued at once, as streaming does
+        const CacheIO::Backend backends[2] = {CacheIO::Backend::IoUring, CacheIO::Backend::Threads};
+        for(int b = 0; b < 2; ++b){
+            CacheIO io(cache, backends[b]);
+            backendNames[b] = io.backendName();
+            asyncRead[b] = bestOf(5, [&]() {
+                std::atomic<int> done{0};
+                for(int c = 0; c < chunks; ++c){
+                    io.read(hash, chunkX(c), chunkZ(c), {cells}, [&, c](HeightGrid grid) {
+                        if(grid.empty() || grid.heights != decodedSimd[c]) asyncOk = false;
+                        done.fetch_add(1, std::memory_order_release);
+                    });
+                }
+                while(done.load(std::memory_order_acquire) < chunks){
+                    std::this_thread::yield();
+                }
+            });
+        }
+    }
+    std::filesystem::remove_all(dir, ec);
+
+    const double decodedMiB = double(rawBytes) / (1024.0 * 1024.0);
+    std::printf("\n%-22s %12s %12s\n", "", "chunks/s", "MiB/s");
+    std::printf("%-22s %12.0f\n", "noise generate", chunks / generate);
+    std::printf("%-22s %12.0f %12.1f\n", "encode", chunks / encode, decodedMiB / encode);
+    std::printf("%-22s %12.0f %12.1f\n", "decode scalar", chunks / decodeScalar, decodedMiB / decodeScalar);
+    std::printf("%-22s %12.0f %12.1f\n", "decode simd", chunks / decodeSimd, decodedMiB / decodeSimd);
+    std::printf("%-22s %12.0f\n", "region read + decode", chunks / cacheRead);
+    for(int b = 0; b < 2; ++b){
+        char label[32];
+        std::snprintf(label, sizeof(label), "async read (%s)", backendNames[b]);
+        std::printf("%-22s %12.0f\n", label, chunks / asyncRead[b]);
+    }
+
+    std::printf("\nsize: %.1f KiB raw -> %.1f KiB encoded per chunk (%.2fx)\n",
+        rawBytes / 1024.0 / chunks, encodedBytes / 1024.0 / chunks, double(rawBytes) / double(encodedBytes));
+    std::printf("max |error| %g (limit %g), scalar/simd identical: %s\n", maxError, precision * 0.5f, identical ? "yes" : "NO");
+    std::printf("cache read vs regenerate: %.1fx faster\n", generate / cacheRead);
+    std::printf("async reads match: %s\n", asyncOk ? "yes" : "NO");
+
+    return identical && asyncOk && maxError <= precision * 0.5f + 1e-6f ? 0 : 1;
+}
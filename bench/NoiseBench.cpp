@@ -0,0 +1,100 @@
+// Microbenchmark for the batched fractal noise kernels and noise backends.
+// Generates LOD0-sized chunk grids with every ISA the CPU supports and
+// reports samples/second plus the max deviation from the scalar path, then
+// runs every NoiseBackend over the same grids.
+
+#include "NoiseBackend.h"
+#include "NoiseKernels.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char** argv){
+    const int cells = 65;
+    const int chunks = (argc > 1) ? std::atoi(argv[1]) : 256;
+    const size_t samples = size_t(cells) * cells;
+
+    // Same parameters World uses
+    NoiseKernels::FractalParams p;
+    p.baseFrequency = 0.004f;
+    p.octaves = 5;
+    p.persistence = 0.48f;
+    p.lacunarity = 2.0f;
+    p.heightScale = 100.0f;
+
+    std::vector<float> xs(samples * chunks), zs(samples * chunks);
+    for(int c = 0; c < chunks; ++c){
+        float ox = (c % 16 - 8) * 64.0f;
+        float oz = (c / 16 - 8) * 64.0f;
+        for(int row = 0; row < cells; ++row){
+            for(int col = 0; col < cells; ++col){
+                size_t i = size_t(c) * samples + size_t(row) * cells + col;
+                xs[i] = ox + col / float(cells - 1) * 64.0f;
+                zs[i] = oz + row / float(cells - 1) * 64.0f;
+            }
+        }
+    }
+
+    std::vector<float> reference(xs.size());
+    NoiseKernels::fractalHeights(NoiseKernels::Isa::Scalar, p, xs.data(), zs.data(), reference.data(), xs.size());
+
+    std::printf("%d chunks of %dx%d, %d octaves, active isa: %s\n",
+        chunks, cells, cells, p.octaves, NoiseKernels::isaName(NoiseKernels::activeIsa()));
+    std::printf("%-8s %14s %10s %12s\n", "isa", "samples/s", "speedup", "max |diff|");
+
+    double scalarRate = 0.0;
+    for(int k = 0; k < int(NoiseKernels::Isa::Count); ++k){
+        NoiseKernels::Isa isa = NoiseKernels::Isa(k);
+        if(!NoiseKernels::isaSupported(isa)){
+            std::printf("%-8s %14s\n", NoiseKernels::isaName(isa), "unsupported");
+            continue;
+        }
+
+        std::vector<float> out(xs.size());
+        double best = 1e30;
+        for(int rep = 0; rep < 5; ++rep){
+            auto t0 = std::chrono::steady_clock::now();
+            for(int c = 0; c < chunks; ++c){
+                size_t off = size_t(c) * samples;
+                NoiseKernels::fractalHeights(isa, p, xs.data() + off, zs.data() + off, out.data() + off, samples);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+        }
+
+        float maxDiff = 0.0f;
+        for(size_t i = 0; i < out.size(); ++i){
+            maxDiff = std::max(maxDiff, std::fabs(out[i] - reference[i]));
+        }
+
+        double rate = double(xs.size()) / best;
+        if(isa == NoiseKernels::Isa::Scalar) scalarRate = rate;
+        std::printf("%-8s %14.0f %9.2fx %12g\n", NoiseKernels::isaName(isa), rate, rate / scalarRate, maxDiff);
+    }
+
+    std::printf("\n%-12s %14s\n", "backend", "samples/s");
+    for(int k = 0; k < int(NoiseType::Count); ++k){
+        std::unique_ptr<NoiseBackend> backend = createNoiseBackend(NoiseType(k), 42);
+
+        std::vector<float> out(xs.size());
+        double best = 1e30;
+        for(int rep = 0; rep < 5; ++rep){
+            auto t0 = std::chrono::steady_clock::now();
+            for(int c = 0; c < chunks; ++c){
+                // One call per row, like TerrainGenerator::generateChunk
+                for(int row = 0; row < cells; ++row){
+                    size_t off = size_t(c) * samples + size_t(row) * cells;
+                    backend->fractalHeights(p, xs.data() + off, zs.data() + off, out.data() + off, cells);
+                }
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+        }
+
+        std::printf("%-12s %14.0f\n", backend->name(), double(xs.size()) / best);
+    }
+
+    return 0;
+}
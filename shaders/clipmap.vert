@@ -0,0 +1,57 @@
+#version 330 core
+
+// One geometry clipmap level: an uSize x uSize grid placed from gl_VertexID,
+// heights fetched from the level's toroidal heightmap (sample g lives at
+// texel g mod uSize). No vertex attributes.
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform sampler2D uHeights;        // this level
+uniform sampler2D uCoarseHeights;  // next coarser level
+uniform vec2 uGridOrigin;          // world x/z of vertex (0, 0)
+uniform float uSpacing;
+uniform int uSize;
+uniform ivec2 uTexOrigin;          // texel of vertex (0, 0)
+uniform ivec2 uCoarseTexOrigin;    // texel of the coarse sample under vertex (0, 0)
+uniform float uMorphWidth;         // vertices over which heights blend into the coarser level, 0 for none
+
+out vec3 vFragPos;
+
+float heightAt(sampler2D tex, ivec2 origin, ivec2 offset)
+{
+    return texelFetch(tex, (origin + offset) % uSize, 0).r;
+}
+
+void main()
+{
+    int row = gl_VertexID / uSize;
+    int col = gl_VertexID - row * uSize;
+    ivec2 v = ivec2(col, row);
+
+    float h = heightAt(uHeights, uTexOrigin, v);
+
+    // Towards the outer edge, blend into the coarser level's surface so the
+    // boundary vertices lie exactly on it: no cracks and no popping when
+    // the level moves. Vertex (0, 0) sits on a coarse sample.
+    if (uMorphWidth > 0.0) {
+        ivec2 c0 = v / 2;
+        ivec2 c1 = (v + 1) / 2;
+        float hc = 0.25 * (heightAt(uCoarseHeights, uCoarseTexOrigin, c0) +
+                           heightAt(uCoarseHeights, uCoarseTexOrigin, ivec2(c1.x, c0.y)) +
+                           heightAt(uCoarseHeights, uCoarseTexOrigin, ivec2(c0.x, c1.y)) +
+                           heightAt(uCoarseHeights, uCoarseTexOrigin, c1));
+
+        float halfSize = float(uSize - 1) * 0.5;
+        vec2 d = abs(vec2(v) - vec2(halfSize));
+        float alpha = clamp((max(d.x, d.y) - (halfSize - uMorphWidth - 1.0)) / uMorphWidth, 0.0, 1.0);
+        h = mix(h, hc, alpha);
+    }
+
+    vec3 aPos = vec3(uGridOrigin.x + float(col) * uSpacing, h, uGridOrigin.y + float(row) * uSpacing);
+
+    vec4 worldPos = model * vec4(aPos, 1.0);
+    vFragPos = worldPos.xyz;
+    gl_Position = projection * view * worldPos;
+}
@@ -1,19 +1,79 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+// Packed TerrainVertex: x/z come from the vertex index on the chunk grid
+layout(location = 0) in float aHeight;     // quantized height in [0, 1]
+layout(location = 1) in vec2 aOctNormal;   // octahedral normal in [-1, 1]
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+uniform vec2 uChunkOrigin;
+uniform float uCellSpacing;
+uniform int uCellsPerSide;
+uniform float uHeightMin;
+uniform float uHeightRange;
+
+// Quadtree nodes only (uMorphEnd 0 elsewhere): between uMorphStart and
+// uMorphEnd from the camera, heights blend into the next coarser level's
+// surface, read from the node's own vertex buffer as GL_R16 texels (the
+// height of vertex i is texel 2i)
+uniform samplerBuffer uVertexHeights;
+uniform vec3 uCameraPos;
+uniform float uMorphStart;
+uniform float uMorphEnd;
+
 out vec3 vNormal;
 out vec3 vFragPos;
 
+vec3 octDecode(vec2 e)
+{
+    // y is the fold axis, matching MeshData::encodeNormal
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    float t = max(-n.y, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.z += (n.z >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+float heightAt(int col, int row)
+{
+    return texelFetch(uVertexHeights, 2 * (row * uCellsPerSide + col)).r;
+}
+
+// Height of the coarser grid (every other vertex) under this vertex. Its
+// cells split along the tr-bl diagonal, like GridIndexBuffer's.
+float coarseHeight(int col, int row, float h)
+{
+    bool oddCol = (col & 1) == 1;
+    bool oddRow = (row & 1) == 1;
+    if (oddCol && oddRow) return 0.5 * (heightAt(col + 1, row - 1) + heightAt(col - 1, row + 1));
+    if (oddCol) return 0.5 * (heightAt(col - 1, row) + heightAt(col + 1, row));
+    if (oddRow) return 0.5 * (heightAt(col, row - 1) + heightAt(col, row + 1));
+    return h;
+}
+
 void main()
 {
+    int row = gl_VertexID / uCellsPerSide;
+    int col = gl_VertexID - row * uCellsPerSide;
+
+    vec3 aPos = vec3(uChunkOrigin.x + float(col) * uCellSpacing,
+                     uHeightMin + aHeight * uHeightRange,
+                     uChunkOrigin.y + float(row) * uCellSpacing);
+
+    // Fully morphed where a coarser node can border this one, so shared
+    // edges match and level changes neither crack nor pop
+    if (uMorphEnd > 0.0) {
+        float k = clamp((distance(uCameraPos, aPos) - uMorphStart) / (uMorphEnd - uMorphStart), 0.0, 1.0);
+        if (k > 0.0) {
+            float h = mix(aHeight, coarseHeight(col, row, aHeight), k);
+            aPos.y = uHeightMin + h * uHeightRange;
+        }
+    }
+
     vec4 worldPos = model * vec4(aPos, 1.0);
     vFragPos = worldPos.xyz;
-    vNormal = mat3(transpose(inverse(model))) * aNormal;
+    vNormal = mat3(transpose(inverse(model))) * octDecode(aOctNormal);
     gl_Position = projection * view * worldPos;
 }
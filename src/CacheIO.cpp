@@ -0,0 +1,431 @@
+#include "CacheIO.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define CACHE_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef CACHE_IO_URING
+// Minimal io_uring: the three shared mappings, one submitter, one reaper
+// (the same thread). Only the operations used here.
+struct CacheIO::Ring {
+    int fd = -1;
+    uint8_t* sq = nullptr;
+    uint8_t* cq = nullptr;
+    size_t sqBytes = 0, cqBytes = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqeBytes = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned toSubmit = 0;
+
+    ~Ring(){
+        if(sqes) munmap(sqes, sqeBytes);
+        if(cq && cq != sq) munmap(cq, cqBytes);
+        if(sq) munmap(sq, sqBytes);
+        if(fd >= 0) ::close(fd);
+    }
+
+    bool setup(unsigned entries){
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        fd = int(syscall(__NR_io_uring_setup, entries, &p));
+        if(fd < 0) return false;
+
+        sqBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if(single) sqBytes = cqBytes = std::max(sqBytes, cqBytes);
+
+        void* s = mmap(nullptr, sqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if(s == MAP_FAILED) return false;
+        sq = static_cast<uint8_t*>(s);
+
+        if(single){
+            cq = sq;
+        }
+        else{
+            void* c = mmap(nullptr, cqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if(c == MAP_FAILED) return false;
+            cq = static_cast<uint8_t*>(c);
+        }
+
+        sqeBytes = p.sq_entries * sizeof(io_uring_sqe);
+        void* e = mmap(nullptr, sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if(e == MAP_FAILED) return false;
+        sqes = static_cast<io_uring_sqe*>(e);
+
+        sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        return true;
+    }
+
+    // The caller keeps at most `entries` operations in flight, so there is
+    // always a free submission slot
+    void prep(uint8_t opcode, int file, void* buffer, uint32_t length, uint64_t offset, uint64_t tag){
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = file;
+        sqe->addr = uint64_t(reinterpret_cast<uintptr_t>(buffer));
+        sqe->len = length;
+        sqe->off = offset;
+        sqe->user_data = tag;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++toSubmit;
+    }
+
+    // Submits everything prepared and waits for at least waitFor completions
+    bool enter(unsigned waitFor){
+        if(toSubmit == 0 && waitFor == 0) return true;
+        for(;;){
+            long n = syscall(__NR_io_uring_enter, fd, toSubmit, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+            if(n >= 0){
+                toSubmit -= std::min(toSubmit, unsigned(n));
+                return true;
+            }
+            if(errno != EINTR) return false;
+        }
+    }
+
+    template<typename Fn>
+    void reap(Fn&& fn){
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for(; head != tail; ++head){
+            const io_uring_cqe& c = cqes[head & *cqMask];
+            fn(c.user_data, c.res);
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+};
+#else
+struct CacheIO::Ring {
+    bool setup(unsigned) { return false; }
+};
+#endif
+
+
+CacheIO::CacheIO(std::shared_ptr<TerrainCache> cache_, Backend preferred)
+    : cache(std::move(cache_))
+{
+    if(preferred == Backend::IoUring){
+        auto r = std::make_unique<Ring>();
+        if(r->setup(RING_ENTRIES)){
+            ring = std::move(r);
+            activeBackend = Backend::IoUring;
+        }
+    }
+
+    if(ring){
+        threads.emplace_back([this]() { ringLoop(); });
+    }
+    else{
+        for(unsigned i = 0; i < FALLBACK_THREADS; ++i){
+            threads.emplace_back([this]() { threadLoop(); });
+        }
+    }
+}
+
+CacheIO::~CacheIO(){
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCv.notify_all();
+
+    for(auto& t : threads){
+        if(t.joinable()) t.join();
+    }
+}
+
+const char* CacheIO::backendName() const{
+    return activeBackend == Backend::IoUring ? "io_uring" : "threads";
+}
+
+void CacheIO::read(uint64_t paramsHash, int cx, int cz, std::vector<int> cellSizes, ReadCallback done){
+    auto r = std::make_unique<Request>();
+    r->kind = Kind::Read;
+    r->paramsHash = paramsHash;
+    r->cx = cx;
+    r->cz = cz;
+    r->cellSizes = std::move(cellSizes);
+    r->done = std::move(done);
+    readCount.fetch_add(1, std::memory_order_relaxed);
+    enqueue(std::move(r));
+}
+
+void CacheIO::readAhead(uint64_t paramsHash, int cx, int cz, std::vector<int> cellSizes){
+    {
+        std::lock_guard<std::mutex> lock(aheadMutex);
+        ChunkId id(paramsHash, cx, cz);
+        if(ahead.count(id) || !aheadPending.insert(id).second) return;
+    }
+
+    auto r = std::make_unique<Request>();
+    r->kind = Kind::ReadAhead;
+    r->paramsHash = paramsHash;
+    r->cx = cx;
+    r->cz = cz;
+    r->cellSizes = std::move(cellSizes);
+    enqueue(std::move(r));
+}
+
+void CacheIO::write(uint64_t paramsHash, int cx, int cz, HeightGrid grid){
+    auto r = std::make_unique<Request>();
+    r->kind = Kind::Write;
+    r->paramsHash = paramsHash;
+    r->cx = cx;
+    r->cz = cz;
+    r->grid = std::move(grid);
+    enqueue(std::move(r));
+}
+
+void CacheIO::enqueue(RequestPtr request){
+    inFlightCount.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        switch(request->kind){
+            case Kind::Read: reads.push_back(std::move(request)); break;
+            case Kind::ReadAhead: readAheads.push_back(std::move(request)); break;
+            case Kind::Write: writes.push_back(std::move(request)); break;
+        }
+    }
+    queueCv.notify_one();
+}
+
+bool CacheIO::popNext(RequestPtr& out){
+    for(std::deque<RequestPtr>* q : {&reads, &readAheads, &writes}){
+        if(q->empty()) continue;
+        out = std::move(q->front());
+        q->pop_front();
+        return true;
+    }
+    return false;
+}
+
+void CacheIO::dropReads(){
+    inFlightCount.fetch_sub(reads.size() + readAheads.size(), std::memory_order_relaxed);
+    reads.clear();
+
+    std::lock_guard<std::mutex> lock(aheadMutex);
+    for(const RequestPtr& r : readAheads){
+        aheadPending.erase(ChunkId(r->paramsHash, r->cx, r->cz));
+    }
+    readAheads.clear();
+}
+
+bool CacheIO::takeBuffered(Request& r){
+    std::lock_guard<std::mutex> lock(aheadMutex);
+    ChunkId id(r.paramsHash, r.cx, r.cz);
+    auto it = ahead.find(id);
+    if(it == ahead.end()) return false;
+    if(std::find(r.cellSizes.begin(), r.cellSizes.end(), it->second.cells) == r.cellSizes.end()) return false;
+
+    r.cells = it->second.cells;
+    r.bytes = std::move(it->second.bytes);
+    ahead.erase(it);
+    aheadOrder.erase(std::find(aheadOrder.begin(), aheadOrder.end(), id));
+    return true;
+}
+
+bool CacheIO::begin(Request& r){
+    if(r.kind == Kind::Write){
+        if(!RegionFile::encodePayload(r.cx, r.cz, r.grid, cache->getPrecision(), r.bytes)) return false;
+        r.cells = r.grid.cellsPerSide;
+        r.grid = HeightGrid();
+        r.region = cache->region(r.paramsHash, r.cx, r.cz, true);
+        return r.region && r.region->reserve(r.bytes.size(), r.offset);
+    }
+
+    if(r.kind == Kind::Read && takeBuffered(r)){
+        r.buffered = true;
+        return false;
+    }
+
+    // The index lives in the region's mapping, only the payload needs I/O
+    r.region = cache->region(r.paramsHash, r.cx, r.cz, false);
+    if(!r.region) return false;
+    for(int cells : r.cellSizes){
+        uint32_t size;
+        if(!r.region->locate(r.cx, r.cz, cells, r.offset, size)) continue;
+        r.cells = cells;
+        r.bytes.resize(size);
+        return true;
+    }
+    return false;
+}
+
+bool CacheIO::performBlocking(Request& r){
+    if(r.kind == Kind::Write) return r.region->writeRaw(r.offset, r.bytes.data(), r.bytes.size());
+    return r.region->readRaw(r.offset, uint32_t(r.bytes.size()), r.bytes.data());
+}
+
+void CacheIO::finish(Request& r, bool ok){
+    switch(r.kind){
+        case Kind::Read: {
+            HeightGrid grid;
+            if(ok && RegionFile::decodePayload(r.cx, r.cz, r.cells, r.bytes.data(), r.bytes.size(), grid)){
+                hitCount.fetch_add(1, std::memory_order_relaxed);
+                if(r.buffered) readAheadHitCount.fetch_add(1, std::memory_order_relaxed);
+                else bytesReadCount.fetch_add(r.bytes.size(), std::memory_order_relaxed);
+            }
+            else{
+                missCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            r.done(std::move(grid));
+            break;
+        }
+        case Kind::ReadAhead: {
+            std::lock_guard<std::mutex> lock(aheadMutex);
+            ChunkId id(r.paramsHash, r.cx, r.cz);
+            aheadPending.erase(id);
+            if(!ok) break;
+
+            readAheadCount.fetch_add(1, std::memory_order_relaxed);
+            bytesReadCount.fetch_add(r.bytes.size(), std::memory_order_relaxed);
+            if(!ahead.count(id)) aheadOrder.push_back(id);
+            ahead[id] = Buffered{r.cells, std::move(r.bytes)};
+            while(ahead.size() > READ_AHEAD_ENTRIES){
+                ahead.erase(aheadOrder.front());
+                aheadOrder.pop_front();
+            }
+            break;
+        }
+        case Kind::Write:
+            // Published only once the payload is in the file
+            if(ok && r.region->publish(r.cx, r.cz, r.cells, r.offset, r.bytes.size())){
+                writeCount.fetch_add(1, std::memory_order_relaxed);
+                bytesWrittenCount.fetch_add(r.bytes.size(), std::memory_order_relaxed);
+            }
+            break;
+    }
+    inFlightCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void CacheIO::threadLoop(){
+    for(;;){
+        RequestPtr r;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCv.wait(lock, [this]() {
+                return stopping || !reads.empty() || !readAheads.empty() || !writes.empty();
+            });
+            if(stopping) dropReads();
+            if(!popNext(r)) return;
+        }
+        batchCount.fetch_add(1, std::memory_order_relaxed);
+
+        bool ok = begin(*r) ? performBlocking(*r) : r->buffered;
+        finish(*r, ok);
+    }
+}
+
+void CacheIO::ringLoop(){
+#ifdef CACHE_IO_URING
+    // Requests on the ring, indexed by their user_data tag
+    std::vector<RequestPtr> slots(RING_ENTRIES);
+    std::vector<unsigned> freeSlots;
+    for(unsigned i = RING_ENTRIES; i-- > 0;) freeSlots.push_back(i);
+    unsigned inFlight = 0;
+
+    for(;;){
+        std::vector<RequestPtr> batch;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if(inFlight == 0){
+                queueCv.wait(lock, [this]() {
+                    return stopping || !reads.empty() || !readAheads.empty() || !writes.empty();
+                });
+            }
+            if(stopping){
+                dropReads();
+                if(writes.empty() && inFlight == 0) return;
+            }
+
+            RequestPtr r;
+            while(inFlight + batch.size() < RING_ENTRIES && popNext(r)){
+                batch.push_back(std::move(r));
+            }
+        }
+
+        for(RequestPtr& r : batch){
+            if(!begin(*r)){
+                finish(*r, r->buffered);
+                continue;
+            }
+
+            unsigned tag = freeSlots.back();
+            freeSlots.pop_back();
+            uint8_t opcode = r->kind == Kind::Write ? IORING_OP_WRITE : IORING_OP_READ;
+            ring->prep(opcode, r->region->descriptor(), r->bytes.data(), uint32_t(r->bytes.size()), r->offset, tag);
+            slots[tag] = std::move(r);
+            ++inFlight;
+        }
+
+        // One syscall submits the whole batch; block only when there is
+        // nothing else to do
+        bool submitting = ring->toSubmit > 0;
+        if(ring->enter(inFlight > 0 && batch.empty() ? 1 : 0)){
+            if(submitting) batchCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        else{
+            // Out of kernel resources; what is unsubmitted stays prepared
+            // and goes with the next round, after reaping
+            std::this_thread::yield();
+        }
+
+        ring->reap([&](uint64_t tag, int32_t res) {
+            RequestPtr r = std::move(slots[tag]);
+            freeSlots.push_back(unsigned(tag));
+            --inFlight;
+
+            // Short transfers and errors (e.g. an opcode the kernel lacks)
+            // are redone with blocking calls
+            bool ok = res >= 0 && size_t(res) == r->bytes.size();
+            if(!ok) ok = performBlocking(*r);
+            finish(*r, ok);
+        });
+    }
+#endif
+}
+
+CacheIO::Stats CacheIO::getStats() const{
+    Stats s;
+    s.reads = readCount.load(std::memory_order_relaxed);
+    s.hits = hitCount.load(std::memory_order_relaxed);
+    s.misses = missCount.load(std::memory_order_relaxed);
+    s.writes = writeCount.load(std::memory_order_relaxed);
+    s.bytesRead = bytesReadCount.load(std::memory_order_relaxed);
+    s.bytesWritten = bytesWrittenCount.load(std::memory_order_relaxed);
+    s.batches = batchCount.load(std::memory_order_relaxed);
+    s.readAheads = readAheadCount.load(std::memory_order_relaxed);
+    s.readAheadHits = readAheadHitCount.load(std::memory_order_relaxed);
+    s.inFlight = inFlightCount.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,137 @@
+#ifndef CACHE_IO_H
+#define CACHE_IO_H
+
+#include "TerrainCache.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Asynchronous front end of the TerrainCache for the streaming code, so no
+// generation worker ever waits on the disk. Requests are queued and run in
+// batches: on Linux through one io_uring (raw syscalls, no liburing), with
+// every read and write queued since the last submission going to the kernel
+// in one call; elsewhere, or when the kernel refuses a ring, on a couple of
+// blocking I/O threads. Reads go first, then read-aheads, then writes.
+//
+// Callbacks run on the I/O thread and should only hand work on (e.g. into
+// the ThreadPool). Reads still queued at destruction are dropped without
+// their callback; queued writes are finished.
+class CacheIO {
+public:
+    enum class Backend { IoUring, Threads };
+
+    struct Stats {
+        uint64_t reads = 0;          // lookups requested
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t writes = 0;         // payloads written
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t batches = 0;        // kernel submissions (ring) or wakeups (threads)
+        uint64_t readAheads = 0;     // payloads fetched before anyone asked
+        uint64_t readAheadHits = 0;  // lookups those served without I/O
+        uint64_t inFlight = 0;       // requests queued or running
+    };
+
+    // Decoded heights, empty on a miss
+    using ReadCallback = std::function<void(HeightGrid grid)>;
+
+    // preferred is only a wish; see backend() for what is used
+    explicit CacheIO(std::shared_ptr<TerrainCache> cache, Backend preferred = Backend::IoUring);
+    ~CacheIO();
+
+    CacheIO(const CacheIO&) = delete;
+    CacheIO& operator=(const CacheIO&) = delete;
+
+    // Reads the first of cellSizes stored for the chunk
+    void read(uint64_t paramsHash, int cx, int cz, std::vector<int> cellSizes, ReadCallback done);
+
+    // Fetches the payload read() would find into memory, so a later read()
+    // skips the disk. Chunks already buffered or being fetched are skipped.
+    void readAhead(uint64_t paramsHash, int cx, int cz, std::vector<int> cellSizes);
+
+    void write(uint64_t paramsHash, int cx, int cz, HeightGrid grid);
+
+    Backend backend() const { return activeBackend; }
+    const char* backendName() const;
+    Stats getStats() const;
+
+private:
+    static constexpr unsigned RING_ENTRIES = 64;       // in-flight operations on the ring
+    static constexpr unsigned FALLBACK_THREADS = 2;
+    static constexpr size_t READ_AHEAD_ENTRIES = 256;  // buffered payloads, oldest dropped first
+
+    enum class Kind { Read, ReadAhead, Write };
+
+    struct Request {
+        Kind kind = Kind::Read;
+        uint64_t paramsHash = 0;
+        int cx = 0, cz = 0;
+        std::vector<int> cellSizes;
+        ReadCallback done;
+        HeightGrid grid;                      // write input
+
+        std::shared_ptr<RegionFile> region;   // kept open while the I/O runs
+        int cells = 0;                        // grid size found / written
+        uint64_t offset = 0;
+        std::vector<uint8_t> bytes;           // payload
+        bool buffered = false;                // served from the read-ahead buffer
+    };
+    using RequestPtr = std::unique_ptr<Request>;
+
+    using ChunkId = std::tuple<uint64_t, int, int>;
+
+    struct Buffered {
+        int cells = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct Ring;
+
+    std::shared_ptr<TerrainCache> cache;
+    Backend activeBackend = Backend::Threads;
+    std::unique_ptr<Ring> ring;
+    std::vector<std::thread> threads;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::deque<RequestPtr> reads, readAheads, writes;
+    bool stopping = false;
+
+    // Read-ahead payloads by chunk, plus the chunks still being fetched
+    std::mutex aheadMutex;
+    std::map<ChunkId, Buffered> ahead;
+    std::deque<ChunkId> aheadOrder;
+    std::set<ChunkId> aheadPending;
+
+    std::atomic<uint64_t> readCount{0}, hitCount{0}, missCount{0};
+    std::atomic<uint64_t> writeCount{0}, bytesReadCount{0}, bytesWrittenCount{0};
+    std::atomic<uint64_t> batchCount{0}, readAheadCount{0}, readAheadHitCount{0};
+    std::atomic<uint64_t> inFlightCount{0};
+
+    void enqueue(RequestPtr request);
+    bool popNext(RequestPtr& out);  // queueMutex held
+    void dropReads();               // queueMutex held
+    void ringLoop();
+    void threadLoop();
+
+    // Prepares a request: true if it needs file I/O (offset and bytes
+    // set), false if there is nothing to transfer
+    bool begin(Request& r);
+    // Runs the I/O of a prepared request with blocking calls
+    bool performBlocking(Request& r);
+    void finish(Request& r, bool ok);
+
+    bool takeBuffered(Request& r);
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "ChunkGrid.h"
+
+ChunkGrid::ChunkGrid(int radius)
+    : width(2 * radius + 1), slots(size_t(width) * size_t(width))
+{
+}
+
+ChunkSlot* ChunkGrid::find(const ChunkKey& key){
+    ChunkSlot& slot = slots[indexFor(key)];
+    return (slot.inUse() && slot.key == key) ? &slot : nullptr;
+}
+
+const ChunkSlot* ChunkGrid::find(const ChunkKey& key) const{
+    const ChunkSlot& slot = slots[indexFor(key)];
+    return (slot.inUse() && slot.key == key) ? &slot : nullptr;
+}
+
+ChunkSlot* ChunkGrid::acquire(const ChunkKey& key){
+    ChunkSlot& slot = slots[indexFor(key)];
+    if (!slot.inUse()) {
+        slot = ChunkSlot();
+        slot.key = key;
+    }
+    return slot.key == key ? &slot : nullptr;
+}
+
+ChunkSlot* ChunkGrid::occupant(const ChunkKey& key){
+    ChunkSlot& slot = slots[indexFor(key)];
+    return (slot.inUse() && !(slot.key == key)) ? &slot : nullptr;
+}
+
+void ChunkGrid::releaseIfUnused(ChunkSlot& slot){
+    if (slot.inUse()) return;
+    slot.pending = PendingChunk();
+    slot.requestedLod = -1;
+}
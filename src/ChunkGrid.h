@@ -0,0 +1,127 @@
+#ifndef CHUNK_GRID_H
+#define CHUNK_GRID_H
+
+#include "ChunkKey.h"
+#include "ColdChunkCache.h"
+#include "TerrainChunk.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// What a chunk job hands back to the main thread
+struct ChunkJobResult {
+    std::vector<MeshData> lods;     // meshes for firstLod, firstLod + 1, ...
+    HeightGrid generated;           // grid evaluated from noise, to be written to the cache
+    uint64_t samplesSaved = 0;      // noise samples a cache hit made unnecessary
+};
+
+struct PendingChunk {
+    JobHandle<ChunkJobResult> job;
+    CancelToken cancel;
+    int firstLod = 0;
+    int lodCount = 1;               // LODs the job produces
+    uint64_t generatorVersion = 0;  // snapshot the job was generated from
+    uint64_t paramsHash = 0;        // cache key of that snapshot
+    uint64_t noiseSamples = 0;      // samples the job evaluates when it runs to the end
+    bool prefetch = false;          // requested for the predicted path, not the current view
+    bool placeholder = false;       // coarse startup stand-in, kept until its chunk leaves the load window
+    std::shared_ptr<const ColdChunkCache::Entry> cold;  // taken from the cold tier, put back if cancelled
+    std::chrono::steady_clock::time_point submitTime;
+};
+
+// Finished job output waiting for the frame-budgeted GPU upload
+struct ReadyChunk {
+    std::vector<MeshData> lods;     // meshes for firstLod, firstLod + 1, ...
+    int firstLod = 0;
+    size_t next = 0;                // first mesh not uploaded yet
+    uint64_t generatorVersion = 0;
+    bool prefetch = false;
+    std::chrono::steady_clock::time_point submitTime;
+};
+
+// Everything Terrain tracks for one chunk coordinate, stored inline
+struct ChunkSlot {
+    ChunkKey key{0, 0};
+    TerrainChunk* chunk = nullptr;  // owned
+    PendingChunk pending;
+    bool hasPending = false;
+    int requestedLod = -1;          // LOD of the pending request, -1 if none
+    ReadyChunk ready;
+    bool hasUpload = false;         // queued in Terrain::uploadKeys
+    bool needsRequest = false;      // queued in Terrain::needsRequest
+
+    // LOD selected for the chunk with hysteresis, -1 until it enters the
+    // load window; requests, drawing and the memory budget all follow it
+    int lod = -1;
+    int previousLod = -1;           // before the last switch, to spot reversals
+    std::chrono::steady_clock::time_point lodSince;
+    bool lodDeferred = false;       // coarsening waits in Terrain::deferredLods
+
+    bool inUse() const { return chunk != nullptr || hasPending || hasUpload || needsRequest; }
+};
+
+// Fixed-capacity toroidal array of chunk slots, indexed by chunk coordinate
+// modulo the side length. Any (2 * radius + 1)^2 window maps every key to
+// its own slot, so as long as callers only keep keys inside one such window
+// (the unload window) lookups are a single index computation.
+class ChunkGrid {
+public:
+    explicit ChunkGrid(int radius);
+
+    int side() const { return width; }
+
+    // Slot holding key, nullptr if the slot is free or holds another key
+    ChunkSlot* find(const ChunkKey& key);
+    const ChunkSlot* find(const ChunkKey& key) const;
+
+    // Slot for key, claimed if free; nullptr while a different key that
+    // has not been released yet still holds it
+    ChunkSlot* acquire(const ChunkKey& key);
+
+    // Slot key maps to if a different key still holds it, else nullptr
+    ChunkSlot* occupant(const ChunkKey& key);
+
+    // Returns the slot to the free state once nothing refers to it
+    void releaseIfUnused(ChunkSlot& slot);
+
+    // Slots in use inside the window around center, row by row
+    template<typename Fn>
+    void forEachInWindow(const ChunkKey& center, int radius, Fn&& fn);
+
+    // Every slot in use, in storage order
+    template<typename Fn>
+    void forEach(Fn&& fn);
+
+private:
+    int width;
+    std::vector<ChunkSlot> slots;
+
+    size_t indexFor(const ChunkKey& key) const {
+        int x = key.x % width;
+        int z = key.z % width;
+        if (x < 0) x += width;
+        if (z < 0) z += width;
+        return size_t(z) * width + size_t(x);
+    }
+};
+
+template<typename Fn>
+void ChunkGrid::forEachInWindow(const ChunkKey& center, int radius, Fn&& fn){
+    for (int z = center.z - radius; z <= center.z + radius; ++z) {
+        for (int x = center.x - radius; x <= center.x + radius; ++x) {
+            ChunkSlot* slot = find(ChunkKey{x, z});
+            if (slot) fn(*slot);
+        }
+    }
+}
+
+template<typename Fn>
+void ChunkGrid::forEach(Fn&& fn){
+    for (ChunkSlot& slot : slots) {
+        if (slot.inUse()) fn(slot);
+    }
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef CHUNK_KEY_H
+#define CHUNK_KEY_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct ChunkKey {
+    int x, z;
+
+    bool operator==(const ChunkKey& other) const {
+        return x == other.x && z == other.z;
+    }
+};
+
+struct ChunkKeyHash {
+    std::size_t operator()(const ChunkKey& k) const {
+        // Pack both coordinates and run a 64-bit finalizer (splitmix64), so
+        // neighbouring keys spread over all buckets instead of clustering
+        uint64_t h = (uint64_t(uint32_t(k.x)) << 32) | uint32_t(k.z);
+        h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return static_cast<std::size_t>(h);
+    }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "ChunkPrefetcher.h"
+#include <algorithm>
+#include <cmath>
+
+void ChunkPrefetcher::observe(float dt, const Camera& camera){
+    clock += dt;
+
+    glm::vec3 pos = camera.getPosition();
+    history.push_back({clock, glm::vec3(pos.x, 0.0f, pos.z), camera.getYaw()});
+    while(history.size() > 2 && clock - history.front().time > HISTORY_SECONDS){
+        history.pop_front();
+    }
+
+    // Average over the window rather than the last frame, which is noisy
+    // with frame-time jitter
+    const Sample& first = history.front();
+    const Sample& last = history.back();
+    float span = last.time - first.time;
+    if(span <= 1e-4f){
+        velocity = glm::vec3(0.0f);
+        yawRate = 0.0f;
+        return;
+    }
+
+    velocity = (last.position - first.position) / span;
+    yawRate = glm::radians(last.yaw - first.yaw) / span;
+    yawRate = std::min(std::max(yawRate, -MAX_YAW_RATE), MAX_YAW_RATE);
+}
+
+void ChunkPrefetcher::recordLatency(float seconds){
+    if(!hasLatency){
+        latency = seconds;
+        hasLatency = true;
+        return;
+    }
+    latency += LATENCY_SMOOTHING * (seconds - latency);
+}
+
+float ChunkPrefetcher::lookahead(float updateDelay) const{
+    return std::min(latency * LATENCY_MARGIN + updateDelay, MAX_LOOKAHEAD);
+}
+
+float ChunkPrefetcher::getSpeed() const{
+    return glm::length(velocity);
+}
+
+std::vector<glm::vec3> ChunkPrefetcher::predictPath(float seconds, int steps) const{
+    std::vector<glm::vec3> path;
+    if(history.empty() || steps <= 0 || seconds <= 0.0f || getSpeed() < MIN_SPEED){
+        return path;
+    }
+
+    // Integrate the velocity while rotating it at the current yaw rate; a
+    // yaw increase turns +x towards +z, the same as Camera's front vector
+    const float dt = seconds / steps;
+    glm::vec3 p = history.back().position;
+    path.reserve(steps);
+    for(int k = 0; k < steps; ++k){
+        float angle = yawRate * (k + 0.5f) * dt;
+        float c = std::cos(angle), s = std::sin(angle);
+        glm::vec3 v(velocity.x * c - velocity.z * s, 0.0f, velocity.x * s + velocity.z * c);
+        p += v * dt;
+        path.push_back(p);
+    }
+    return path;
+}
@@ -0,0 +1,56 @@
+#ifndef CHUNK_PREFETCHER_H
+#define CHUNK_PREFETCHER_H
+
+#include "Camera.h"
+#include <deque>
+#include <vector>
+
+// Extrapolates the camera's horizontal trajectory from its recent positions
+// and yaw rate (constant speed, constant turn rate) so Terrain can request
+// chunks before the camera reaches them. The lookahead follows the measured
+// time from request to usable chunk.
+class ChunkPrefetcher {
+public:
+    // Call once per frame, before any update gating
+    void observe(float dt, const Camera& camera);
+
+    // Seconds between a chunk request and its result being finalized
+    void recordLatency(float seconds);
+
+    // How far ahead to predict: expected latency plus the delay until the
+    // next terrain update, clamped to MAX_LOOKAHEAD
+    float lookahead(float updateDelay) const;
+
+    // Predicted camera positions at `steps` evenly spaced times in
+    // (0, seconds]; empty while the camera is (nearly) stationary
+    std::vector<glm::vec3> predictPath(float seconds, int steps) const;
+
+    glm::vec3 getVelocity() const { return velocity; }
+    float getSpeed() const;
+    float getLatency() const { return latency; }
+
+private:
+    struct Sample {
+        float time;
+        glm::vec3 position;
+        float yaw;  // degrees, unwrapped as Camera keeps it
+    };
+
+    static constexpr float HISTORY_SECONDS = 0.5f;   // window for the velocity fit
+    static constexpr float MIN_SPEED = 2.0f;         // units/s below which nothing is predicted
+    static constexpr float MAX_LOOKAHEAD = 4.0f;     // seconds
+    static constexpr float LATENCY_MARGIN = 1.5f;    // headroom over the average latency
+    static constexpr float LATENCY_SMOOTHING = 0.1f; // EMA weight of a new sample
+    static constexpr float MAX_YAW_RATE = 3.14159265f; // rad/s, ignores mouse flicks beyond
+
+    std::deque<Sample> history;
+    float clock = 0.0f;
+
+    glm::vec3 velocity = glm::vec3(0.0f);  // horizontal, units/s
+    float yawRate = 0.0f;                  // rad/s
+
+    float latency = 0.25f;  // seconds, initial guess until the first job completes
+    bool hasLatency = false;
+};
+
+#endif
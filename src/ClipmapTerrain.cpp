@@ -0,0 +1,200 @@
+#include "ClipmapTerrain.h"
+#include "GridIndexBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+ClipmapTerrain::ClipmapTerrain(TerrainGenerator& generator_, float worldScale_, int levelCount)
+    : generator(generator_), worldScale(worldScale_), levels(std::max(levelCount, 1))
+{
+    for (Level& lv : levels) {
+        glGenTextures(1, &lv.texture);
+        glBindTexture(GL_TEXTURE_2D, lv.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, GRID_SIZE, GRID_SIZE, 0, GL_RED, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    meshes[0] = createMesh(0, 0, 0);
+    for (int i = 0; i < 4; ++i) {
+        meshes[1 + i] = createMesh(HOLE_CELLS / 2 + (i & 1), HOLE_CELLS / 2 + (i >> 1), HOLE_CELLS);
+    }
+
+    stats.levels = int(levels.size());
+    stats.gridSize = GRID_SIZE;
+    stats.textureBytes = levels.size() * size_t(GRID_SIZE) * GRID_SIZE * sizeof(float);
+    stats.viewDistance = spacing(stats.levels - 1) * float(GRID_SIZE - 1) * 0.5f;
+}
+
+ClipmapTerrain::~ClipmapTerrain(){
+    for (Level& lv : levels) glDeleteTextures(1, &lv.texture);
+    for (GridMesh& m : meshes) {
+        glDeleteBuffers(1, &m.ebo);
+        glDeleteVertexArrays(1, &m.vao);
+    }
+}
+
+ClipmapTerrain::GridMesh ClipmapTerrain::createMesh(int holeCol, int holeRow, int holeCells){
+    std::vector<uint16_t> indices = GridIndexBuffer::buildIndices(GRID_SIZE, holeCol, holeRow, holeCells);
+
+    GridMesh m;
+    m.count = GLsizei(indices.size());
+    glGenVertexArrays(1, &m.vao);
+    glBindVertexArray(m.vao);
+    glGenBuffers(1, &m.ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    return m;
+}
+
+void ClipmapTerrain::update(float, const Camera& camera){
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    stats.samplesLastFrame = 0;
+    stats.texelsUploadedLastFrame = 0;
+
+    TerrainGenerator::SnapshotPtr gen = generator.snapshot();
+    const glm::vec3 pos = camera.getPosition();
+
+    // Even origins keep every level on its coarser neighbour's samples
+    for (int l = 0; l < int(levels.size()); ++l) {
+        const float s2 = 2.0f * spacing(l);
+        const int originX = 2 * int(std::floor(pos.x / s2)) - HOLE_CELLS;
+        const int originZ = 2 * int(std::floor(pos.z / s2)) - HOLE_CELLS;
+        updateLevel(l, originX, originZ, *gen);
+    }
+
+    std::chrono::duration<float, std::micro> took = Clock::now() - start;
+    stats.updateMicros = took.count();
+}
+
+void ClipmapTerrain::updateLevel(int l, int originX, int originZ, const TerrainGenerator::Snapshot& gen){
+    Level& lv = levels[l];
+    const int dx = originX - lv.originX;
+    const int dz = originZ - lv.originZ;
+
+    if (!lv.valid || lv.generatorVersion != gen.getVersion() || std::abs(dx) >= GRID_SIZE || std::abs(dz) >= GRID_SIZE) {
+        fillRect(l, originX, originX + GRID_SIZE, originZ, originZ + GRID_SIZE, gen);
+        ++stats.fullRefreshes;
+    }
+    else if (dx != 0 || dz != 0) {
+        // New columns over the whole new window, then new rows over the
+        // columns both windows share: an L-shaped strip
+        if (dx > 0) fillRect(l, lv.originX + GRID_SIZE, originX + GRID_SIZE, originZ, originZ + GRID_SIZE, gen);
+        else if (dx < 0) fillRect(l, originX, lv.originX, originZ, originZ + GRID_SIZE, gen);
+
+        const int x0 = std::max(originX, lv.originX);
+        const int x1 = std::min(originX, lv.originX) + GRID_SIZE;
+        if (dz > 0) fillRect(l, x0, x1, lv.originZ + GRID_SIZE, originZ + GRID_SIZE, gen);
+        else if (dz < 0) fillRect(l, x0, x1, originZ, lv.originZ, gen);
+        ++stats.stripUpdates;
+    }
+
+    lv.originX = originX;
+    lv.originZ = originZ;
+    lv.valid = true;
+    lv.generatorVersion = gen.getVersion();
+}
+
+void ClipmapTerrain::fillRect(int l, int x0, int x1, int z0, int z1, const TerrainGenerator::Snapshot& gen){
+    if (x1 <= x0 || z1 <= z0) return;
+
+    // A range of at most GRID_SIZE samples wraps around the texture at
+    // most once: split it into up to two runs of consecutive texels
+    struct Run { int first, count, texel; };
+    auto split = [](int a, int b, Run* runs) {
+        const int texel = wrap(a);
+        const int count = std::min(b - a, GRID_SIZE - texel);
+        runs[0] = Run{a, count, texel};
+        runs[1] = Run{a + count, b - a - count, 0};
+    };
+    Run xr[2], zr[2];
+    split(x0, x1, xr);
+    split(z0, z1, zr);
+
+    const float s = spacing(l);
+    glBindTexture(GL_TEXTURE_2D, levels[l].texture);
+    for (const Run& rz : zr) {
+        for (const Run& rx : xr) {
+            if (rx.count == 0 || rz.count == 0) continue;
+
+            const size_t n = size_t(rx.count) * size_t(rz.count);
+            xs.resize(n);
+            zs.resize(n);
+            heights.resize(n);
+            size_t i = 0;
+            for (int z = 0; z < rz.count; ++z) {
+                for (int x = 0; x < rx.count; ++x, ++i) {
+                    xs[i] = float(rx.first + x) * s;
+                    zs[i] = float(rz.first + z) * s;
+                }
+            }
+            gen.sampleHeights(xs.data(), zs.data(), heights.data(), n);
+
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rx.texel, rz.texel, rx.count, rz.count, GL_RED, GL_FLOAT, heights.data());
+            stats.samplesGenerated += n;
+            stats.samplesLastFrame += n;
+            stats.texelsUploadedLastFrame += n;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void ClipmapTerrain::draw(const Shader& shader, const Frustum& f, bool wireframe){
+    stats.drawCalls = 0;
+    if (!levels[0].valid) return;
+
+    TerrainGenerator::SnapshotPtr gen = generator.snapshot();
+    const float heightLo = gen->heightMin();
+    const float heightHi = gen->heightMin() + gen->heightRange();
+
+    shader.setInt("uHeights", 0);
+    shader.setInt("uCoarseHeights", 1);
+    shader.setInt("uSize", GRID_SIZE);
+
+    glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
+
+    for (int l = 0; l < int(levels.size()); ++l) {
+        const Level& lv = levels[l];
+        const float s = spacing(l);
+        glm::vec3 minB(lv.originX * s, heightLo, lv.originZ * s);
+        glm::vec3 maxB((lv.originX + GRID_SIZE - 1) * s, heightHi, (lv.originZ + GRID_SIZE - 1) * s);
+        if (!isInFrustum(f, minB, maxB)) continue;
+
+        // The coarsest level has nothing to blend into
+        const bool last = l + 1 == int(levels.size());
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, lv.texture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, last ? lv.texture : levels[l + 1].texture);
+
+        shader.setVec2("uGridOrigin", glm::vec2(lv.originX * s, lv.originZ * s));
+        shader.setFloat("uSpacing", s);
+        shader.setIVec2("uTexOrigin", glm::ivec2(wrap(lv.originX), wrap(lv.originZ)));
+        shader.setIVec2("uCoarseTexOrigin", glm::ivec2(wrap(lv.originX / 2), wrap(lv.originZ / 2)));
+        shader.setFloat("uMorphWidth", last ? 0.0f : MORPH_WIDTH);
+
+        // Rings leave out the cells the finer level covers
+        const GridMesh* mesh = &meshes[0];
+        if (l > 0) {
+            const Level& fine = levels[l - 1];
+            const int kx = std::clamp(fine.originX / 2 - lv.originX - HOLE_CELLS / 2, 0, 1);
+            const int kz = std::clamp(fine.originZ / 2 - lv.originZ - HOLE_CELLS / 2, 0, 1);
+            mesh = &meshes[1 + kx + 2 * kz];
+        }
+        glBindVertexArray(mesh->vao);
+        glDrawElements(GL_TRIANGLES, mesh->count, GL_UNSIGNED_SHORT, 0);
+        ++stats.drawCalls;
+    }
+
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+}
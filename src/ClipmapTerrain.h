@@ -0,0 +1,82 @@
+#ifndef CLIPMAP_TERRAIN_H
+#define CLIPMAP_TERRAIN_H
+
+#include <glad/glad.h>
+#include "Camera.h"
+#include "Shader.h"
+#include "TerrainGenerator.h"
+#include <cstdint>
+#include <vector>
+
+// Geometry clipmap: `levels` nested GRID_SIZE x GRID_SIZE grids centred on
+// the camera, spacing doubling per level. Each level keeps its heights in
+// a GRID_SIZE x GRID_SIZE float texture addressed toroidally (sample g at
+// texel g mod GRID_SIZE), so when the camera moves only the newly exposed
+// L-shaped strip of samples is generated and uploaded. Vertex positions
+// come from gl_VertexID; the rings share a few static index buffers. Memory
+// and draw calls are fixed by `levels`, whatever the view distance.
+class ClipmapTerrain {
+public:
+    struct Stats {
+        int levels = 0;
+        int gridSize = 0;                     // samples per level side
+        size_t drawCalls = 0;                 // last frame
+        size_t textureBytes = 0;              // all level heightmaps
+        uint64_t samplesGenerated = 0;
+        size_t samplesLastFrame = 0;          // generated by the last update
+        size_t texelsUploadedLastFrame = 0;
+        uint64_t stripUpdates = 0;            // incremental level updates
+        uint64_t fullRefreshes = 0;           // levels regenerated whole
+        float updateMicros = 0.0f;            // last update
+        float viewDistance = 0.0f;            // half the coarsest level's extent
+    };
+
+    ClipmapTerrain(TerrainGenerator& generator, float worldScale, int levels = 8);
+    ~ClipmapTerrain();
+
+    void update(float dt, const Camera& camera);
+    void draw(const Shader& shader, const Frustum& f, bool wireframe);
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    static constexpr int GRID_SIZE = 129;                // odd, so a level has a centre vertex
+    static constexpr int HOLE_CELLS = (GRID_SIZE - 1) / 2;  // the finer level inside a ring
+    static constexpr float MORPH_WIDTH = GRID_SIZE / 10.0f;
+
+    struct Level {
+        GLuint texture = 0;
+        int originX = 0, originZ = 0;  // in samples of this level; always even
+        bool valid = false;
+        uint64_t generatorVersion = 0;
+    };
+
+    // VAO without attributes plus element buffer: one full grid for the
+    // finest level, and one ring per position of the finer level's hole
+    // (it sits 32 or 33 coarse cells in from either side)
+    struct GridMesh {
+        GLuint vao = 0;
+        GLuint ebo = 0;
+        GLsizei count = 0;
+    };
+
+    TerrainGenerator& generator;
+    float worldScale;
+    std::vector<Level> levels;
+    GridMesh meshes[5];
+
+    Stats stats;
+
+    float spacing(int level) const { return worldScale * float(1 << level); }
+    static int wrap(int sample) { return ((sample % GRID_SIZE) + GRID_SIZE) % GRID_SIZE; }
+    static GridMesh createMesh(int holeCol, int holeRow, int holeCells);
+
+    // Moves the level to its new origin, filling only what came into view
+    void updateLevel(int l, int originX, int originZ, const TerrainGenerator::Snapshot& gen);
+    // Generates samples [x0, x1) x [z0, z1) of the level into their texels
+    void fillRect(int l, int x0, int x1, int z0, int z1, const TerrainGenerator::Snapshot& gen);
+
+    std::vector<float> xs, zs, heights;  // fillRect scratch
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "ColdChunkCache.h"
+#include <iterator>
+
+ColdChunkCache::Entry ColdChunkCache::Entry::encode(const HeightGrid& grid, uint64_t generatorVersion, float precision){
+    Entry e;
+    if (grid.empty()) return e;
+
+    // The apron is cheap to recompute and not worth the memory
+    const int cells = grid.cellsPerSide;
+    std::vector<float> interior;
+    const float* heights = grid.heights.data();
+    if (grid.apron > 0) {
+        interior.resize(size_t(cells) * size_t(cells));
+        for (int row = 0; row < cells; ++row) {
+            for (int col = 0; col < cells; ++col) {
+                interior[size_t(row) * cells + col] = grid.at(row, col);
+            }
+        }
+        heights = interior.data();
+    }
+
+    if (!HeightCodec::encode(heights, cells, cells, precision, e.bytes)) {
+        e.bytes.clear();
+        return e;
+    }
+    e.bytes.shrink_to_fit();
+    e.generatorVersion = generatorVersion;
+    e.cellsPerSide = grid.cellsPerSide;
+    return e;
+}
+
+HeightGrid ColdChunkCache::Entry::decode() const{
+    HeightGrid grid;
+    const size_t count = size_t(cellsPerSide) * size_t(cellsPerSide);
+    grid.heights.resize(count);
+    if (!HeightCodec::decode(bytes.data(), bytes.size(), grid.heights.data(), count)) return HeightGrid();
+
+    grid.cellsPerSide = cellsPerSide;
+    grid.apron = 0;
+    return grid;
+}
+
+ColdChunkCache::ColdChunkCache(size_t budgetBytes)
+    : budget(budgetBytes)
+{
+}
+
+void ColdChunkCache::setBudget(size_t bytes){
+    budget = bytes;
+    evictToBudget();
+}
+
+void ColdChunkCache::put(const ChunkKey& key, Entry entry){
+    if (entry.empty()) return;
+
+    auto it = index.find(key);
+    if (it != index.end()) erase(it->second);
+
+    const size_t bytes = entry.bytes.size();
+    stats.bytes += bytes;
+    ++stats.entries;
+    ++stats.stored;
+    lru.push_front(Node{key, std::move(entry), bytes});
+    index[key] = lru.begin();
+    evictToBudget();
+}
+
+ColdChunkCache::Entry ColdChunkCache::take(const ChunkKey& key, uint64_t generatorVersion, int cells){
+    auto it = index.find(key);
+    if (it == index.end()) return Entry();
+
+    auto node = it->second;
+    if (node->entry.generatorVersion != generatorVersion) {
+        erase(node);
+        ++stats.evicted;
+        return Entry();
+    }
+
+    // Only grids that nest into the requested one; a coarser entry stays
+    // for a later, coarser request
+    const int stored = node->entry.cellsPerSide;
+    if (cells <= 1 || stored < cells || (stored - 1) % (cells - 1) != 0) return Entry();
+
+    Entry e = std::move(node->entry);
+    erase(node);
+    ++stats.hits;
+    return e;
+}
+
+ColdChunkCache::Stats ColdChunkCache::getStats() const{
+    Stats s = stats;
+    s.budget = budget;
+    return s;
+}
+
+void ColdChunkCache::clear(){
+    lru.clear();
+    index.clear();
+    stats.entries = 0;
+    stats.bytes = 0;
+}
+
+void ColdChunkCache::erase(std::list<Node>::iterator it){
+    stats.bytes -= it->bytes;
+    --stats.entries;
+    index.erase(it->key);
+    lru.erase(it);
+}
+
+void ColdChunkCache::evictToBudget(){
+    while (stats.bytes > budget && !lru.empty()) {
+        erase(std::prev(lru.end()));
+        ++stats.evicted;
+    }
+}
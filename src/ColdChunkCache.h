@@ -0,0 +1,73 @@
+#ifndef COLD_CHUNK_CACHE_H
+#define COLD_CHUNK_CACHE_H
+
+#include "ChunkKey.h"
+#include "HeightCodec.h"
+#include "TerrainGenerator.h"
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// In-memory tier between resident chunks and nothing: the compressed heights
+// of recently unloaded chunks, so coming back to an area costs a re-mesh and
+// an upload instead of the noise (or the disk). Entries are kept under a
+// byte budget and evicted least recently stored first. Main thread only;
+// encoding and decoding happen in the caller's jobs.
+class ColdChunkCache {
+public:
+    struct Entry {
+        uint64_t generatorVersion = 0;
+        int cellsPerSide = 0;
+        std::vector<uint8_t> bytes;  // HeightCodec, cellsPerSide^2 samples, no apron
+
+        bool empty() const { return bytes.empty(); }
+
+        // Interior samples only; any apron is dropped
+        static Entry encode(const HeightGrid& grid, uint64_t generatorVersion, float precision = HeightCodec::DEFAULT_PRECISION);
+        HeightGrid decode() const;  // empty on malformed data
+    };
+
+    struct Stats {
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t budget = 0;
+        uint64_t stored = 0;
+        uint64_t hits = 0;
+        uint64_t evicted = 0;  // dropped for the budget or a newer generator
+    };
+
+    explicit ColdChunkCache(size_t budgetBytes);
+
+    // Evicts down to the new budget right away
+    void setBudget(size_t bytes);
+    size_t getBudget() const { return budget; }
+
+    // Replaces an older entry for the same chunk
+    void put(const ChunkKey& key, Entry entry);
+
+    // Removes and returns the entry if it comes from generatorVersion and
+    // decimates to `cells`; empty otherwise. Entries of other versions are
+    // dropped on the way.
+    Entry take(const ChunkKey& key, uint64_t generatorVersion, int cells);
+
+    void clear();
+    Stats getStats() const;
+
+private:
+    struct Node {
+        ChunkKey key;
+        Entry entry;
+        size_t bytes;  // entry.bytes.size() when stored
+    };
+
+    size_t budget;
+    std::list<Node> lru;  // most recent first
+    std::unordered_map<ChunkKey, std::list<Node>::iterator, ChunkKeyHash> index;
+    Stats stats;
+
+    void erase(std::list<Node>::iterator it);
+    void evictToBudget();
+};
+
+#endif
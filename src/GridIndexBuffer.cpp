@@ -0,0 +1,66 @@
+#include "GridIndexBuffer.h"
+#include "glad/glad.h"
+#include <stdexcept>
+
+std::unordered_map<int, GridIndexBuffer>& GridIndexBuffer::registry(){
+    static std::unordered_map<int, GridIndexBuffer> buffers;
+    return buffers;
+}
+
+const GridIndexBuffer& GridIndexBuffer::get(int cellsPerSide){
+    auto& buffers = registry();
+    auto it = buffers.find(cellsPerSide);
+    if(it != buffers.end()) return it->second;
+
+    if(cellsPerSide < 2 || cellsPerSide > MAX_CELLS_PER_SIDE){
+        throw std::invalid_argument("GridIndexBuffer: cellsPerSide out of 16-bit index range");
+    }
+
+    std::vector<uint16_t> indices = buildIndices(cellsPerSide);
+
+    GridIndexBuffer buffer;
+    buffer.indexCount = static_cast<unsigned int>(indices.size());
+
+    // Unbind any VAO so creating the buffer does not rebind its element array
+    glBindVertexArray(0);
+    glGenBuffers(1, &buffer.EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return buffers.emplace(cellsPerSide, buffer).first->second;
+}
+
+void GridIndexBuffer::releaseAll(){
+    for(auto& it : registry()){
+        glDeleteBuffers(1, &it.second.EBO);
+    }
+    registry().clear();
+}
+
+std::vector<uint16_t> GridIndexBuffer::buildIndices(int cellsPerSide, int holeCol, int holeRow, int holeCells){
+    std::vector<uint16_t> indices;
+    indices.reserve(size_t(cellsPerSide - 1) * size_t(cellsPerSide - 1) * 6);
+
+    for(int row = 0; row < cellsPerSide - 1; ++row){
+        for(int col = 0; col < cellsPerSide - 1; ++col){
+            if(row >= holeRow && row < holeRow + holeCells && col >= holeCol && col < holeCol + holeCells) continue;
+
+            uint16_t tl = static_cast<uint16_t>(row * cellsPerSide + col);
+            uint16_t tr = static_cast<uint16_t>(tl + 1);
+            uint16_t bl = static_cast<uint16_t>((row + 1) * cellsPerSide + col);
+            uint16_t br = static_cast<uint16_t>(bl + 1);
+
+            // Triangle 1
+            indices.push_back(tl);
+            indices.push_back(bl);
+            indices.push_back(tr);
+
+            // Triangle 2
+            indices.push_back(tr);
+            indices.push_back(bl);
+            indices.push_back(br);
+        }
+    }
+    return indices;
+}
@@ -0,0 +1,33 @@
+#ifndef GRID_INDEX_BUFFER_H
+#define GRID_INDEX_BUFFER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Triangle list for a square vertex grid depends only on its size, so every
+// chunk LOD of the same resolution shares one immutable 16-bit element
+// buffer instead of uploading its own copy. Main thread only (GL context).
+class GridIndexBuffer {
+public:
+    unsigned int EBO = 0;
+    unsigned int indexCount = 0;
+
+    // Largest grid whose vertex indices fit in 16 bits
+    static constexpr int MAX_CELLS_PER_SIDE = 256;
+
+    // Buffer for a grid with cellsPerSide vertices per side, created on first use
+    static const GridIndexBuffer& get(int cellsPerSide);
+
+    // Deletes every buffer; meshes still referencing them must be gone
+    static void releaseAll();
+
+    // tl/bl/tr, tr/bl/br per cell, row-major; cells in the holeCells
+    // square starting at (holeCol, holeRow) are left out
+    static std::vector<uint16_t> buildIndices(int cellsPerSide, int holeCol = 0, int holeRow = 0, int holeCells = 0);
+
+private:
+    static std::unordered_map<int, GridIndexBuffer>& registry();
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "HeightCodec.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr uint8_t FORMAT_VERSION = 1;
+    constexpr uint32_t MAX_SIDE = 1u << 16;
+
+    // |q| below 2^24 converts to float exactly, so every decode path
+    // returns bit-identical heights
+    constexpr double QUANT_LIMIT = double(1 << 24);
+
+    inline uint32_t zigzag(int32_t v) { return (uint32_t(v) << 1) ^ uint32_t(v >> 31); }
+    inline int32_t unzigzag(uint32_t v) { return int32_t(v >> 1) ^ -int32_t(v & 1); }
+
+    void putVarint(uint32_t v, std::vector<uint8_t>& out){
+        while(v >= 0x80){
+            out.push_back(uint8_t(v) | 0x80);
+            v >>= 7;
+        }
+        out.push_back(uint8_t(v));
+    }
+
+    // False on truncated or over-long input
+    inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v){
+        uint32_t result = 0;
+        for(int shift = 0; shift < 35; shift += 7){
+            if(p == end) return false;
+            uint8_t b = *p++;
+            result |= uint32_t(b & 0x7f) << shift;
+            if(!(b & 0x80)){
+                v = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool readHeader(const uint8_t*& p, const uint8_t* end, HeightCodec::Info& info){
+        if(p == end || *p++ != FORMAT_VERSION) return false;
+
+        uint32_t w, h;
+        if(!getVarint(p, end, w) || !getVarint(p, end, h)) return false;
+        if(w == 0 || h == 0 || w > MAX_SIDE || h > MAX_SIDE) return false;
+
+        float precision;
+        if(end - p < ptrdiff_t(sizeof(precision))) return false;
+        std::memcpy(&precision, p, sizeof(precision));
+        p += sizeof(precision);
+        if(!(precision > 0.0f) || !std::isfinite(precision)) return false;
+
+        info.width = int(w);
+        info.height = int(h);
+        info.precision = precision;
+        return true;
+    }
+
+    // One row of residuals. The vector path takes 16 one-byte varints per
+    // step, the common case for smooth terrain.
+    template<bool Simd>
+    bool readRow(const uint8_t*& p, const uint8_t* end, int32_t* res, int width){
+        int c = 0;
+        while(c < width){
+#if defined(__SSE2__)
+            if(Simd && width - c >= 16 && end - p >= 16){
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if(_mm_movemask_epi8(bytes) == 0){
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i one = _mm_set1_epi32(1);
+                    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+                    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+                    __m128i v[4] = {
+                        _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                        _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)
+                    };
+                    for(int k = 0; k < 4; ++k){
+                        __m128i sign = _mm_sub_epi32(zero, _mm_and_si128(v[k], one));
+                        __m128i r = _mm_xor_si128(_mm_srli_epi32(v[k], 1), sign);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(res + c + 4 * k), r);
+                    }
+                    p += 16;
+                    c += 16;
+                    continue;
+                }
+            }
+#endif
+            uint32_t v;
+            if(!getVarint(p, end, v)) return false;
+            res[c++] = unzigzag(v);
+        }
+        return true;
+    }
+
+    // Planar prediction telescopes: the row's difference to the row above
+    // is the prefix sum of its residuals. Wrapping unsigned arithmetic keeps
+    // malformed input defined.
+    template<bool Simd>
+    void reconstructRow(const int32_t* res, int32_t* prev, float* out, int width, float precision){
+        int c = 0;
+        uint32_t d = 0;
+#if defined(__SSE2__)
+        if(Simd){
+            const __m128 scale = _mm_set1_ps(precision);
+            __m128i carry = _mm_setzero_si128();
+            for(; c + 4 <= width; c += 4){
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(res + c));
+                v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+                v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+                v = _mm_add_epi32(v, carry);
+                carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+
+                __m128i x = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + c)), v);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(prev + c), x);
+                _mm_storeu_ps(out + c, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+            }
+            d = uint32_t(_mm_cvtsi128_si32(carry));
+        }
+#endif
+        for(; c < width; ++c){
+            d += uint32_t(res[c]);
+            uint32_t x = uint32_t(prev[c]) + d;
+            prev[c] = int32_t(x);
+            out[c] = float(int32_t(x)) * precision;
+        }
+    }
+
+    template<bool Simd>
+    bool decodeImpl(const uint8_t* data, size_t size, float* out, size_t outCount){
+        const uint8_t* p = data;
+        const uint8_t* end = data + size;
+
+        HeightCodec::Info info;
+        if(!readHeader(p, end, info)) return false;
+        if(size_t(info.width) * size_t(info.height) != outCount) return false;
+
+        // The row above the first one is all zeros
+        std::vector<int32_t> prev(size_t(info.width), 0);
+        std::vector<int32_t> res(size_t(info.width));
+        for(int r = 0; r < info.height; ++r){
+            if(!readRow<Simd>(p, end, res.data(), info.width)) return false;
+            reconstructRow<Simd>(res.data(), prev.data(), out + size_t(r) * info.width, info.width, info.precision);
+        }
+        return p == end;
+    }
+}
+
+bool HeightCodec::encode(const float* heights, int width, int height, float precision, std::vector<uint8_t>& out){
+    if(width <= 0 || height <= 0 || uint32_t(width) > MAX_SIDE || uint32_t(height) > MAX_SIDE) return false;
+    if(!(precision > 0.0f) || !std::isfinite(precision)) return false;
+
+    const size_t count = size_t(width) * size_t(height);
+    std::vector<int32_t> q(count);
+    for(size_t i = 0; i < count; ++i){
+        double t = std::floor(double(heights[i]) / double(precision) + 0.5);
+        if(!(std::fabs(t) < QUANT_LIMIT)) return false;  // also rejects NaN
+        q[i] = int32_t(t);
+    }
+
+    out.push_back(FORMAT_VERSION);
+    putVarint(uint32_t(width), out);
+    putVarint(uint32_t(height), out);
+    const uint8_t* pb = reinterpret_cast<const uint8_t*>(&precision);
+    out.insert(out.end(), pb, pb + sizeof(precision));
+
+    // Samples outside the grid predict as zero, so the first row falls back
+    // to its left neighbour and the first column to the one above
+    for(int r = 0; r < height; ++r){
+        const int32_t* row = q.data() + size_t(r) * width;
+        const int32_t* up = r > 0 ? row - width : nullptr;
+        for(int c = 0; c < width; ++c){
+            int32_t left = c > 0 ? row[c - 1] : 0;
+            int32_t above = up ? up[c] : 0;
+            int32_t corner = (up && c > 0) ? up[c - 1] : 0;
+            putVarint(zigzag(row[c] - (left + above - corner)), out);
+        }
+    }
+    return true;
+}
+
+bool HeightCodec::peek(const uint8_t* data, size_t size, Info& info){
+    const uint8_t* p = data;
+    return readHeader(p, data + size, info);
+}
+
+bool HeightCodec::decode(const uint8_t* data, size_t size, float* out, size_t outCount){
+    return decodeImpl<true>(data, size, out, outCount);
+}
+
+bool HeightCodec::decodeScalar(const uint8_t* data, size_t size, float* out, size_t outCount){
+    return decodeImpl<false>(data, size, out, outCount);
+}
+
+const char* HeightCodec::decodePathName(){
+#if defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
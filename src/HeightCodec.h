@@ -0,0 +1,44 @@
+#ifndef HEIGHT_CODEC_H
+#define HEIGHT_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact encoding for row-major height grids. Heights are quantized to a
+// multiple of `precision` (world units), each sample is predicted from its
+// left, upper and upper-left neighbours (planar predictor) and the integer
+// residuals are zigzag/varint coded. Decoding reproduces the quantized
+// heights exactly; the only loss is the quantization itself, at most half a
+// step. Smooth terrain leaves mostly one-byte residuals, which the SSE2
+// decode path consumes 16 at a time.
+//
+// Quantization is absolute (round(h / precision)), so neighbouring chunks
+// agree on their shared edge samples.
+namespace HeightCodec {
+
+    constexpr float DEFAULT_PRECISION = 1.0f / 256.0f;
+
+    struct Info {
+        int width = 0;
+        int height = 0;
+        float precision = 0.0f;
+    };
+
+    // Appends the encoding to out. False (out unchanged) if a height does
+    // not fit the quantizer at this precision.
+    bool encode(const float* heights, int width, int height, float precision, std::vector<uint8_t>& out);
+
+    // Header only, no decoding
+    bool peek(const uint8_t* data, size_t size, Info& info);
+
+    // out must hold width * height floats. False on malformed input.
+    bool decode(const uint8_t* data, size_t size, float* out, size_t outCount);
+
+    // Portable reference path; identical output
+    bool decodeScalar(const uint8_t* data, size_t size, float* out, size_t outCount);
+
+    const char* decodePathName();
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include "LodChain.h"
+#include "GridIndexBuffer.h"
+#include "RegionFile.h"
+#include <cstdio>
+#include <sstream>
+#include <utility>
+
+LodChain::LodChain()
+    : levels{{65, 150.0f}, {33, 300.0f}, {17, 1050.0f}}
+{
+}
+
+LodChain::LodChain(std::vector<LodLevel> levels_){
+    for (const LodLevel& l : levels_) {
+        int slot;
+        if (l.cells < 2 || l.cells > GridIndexBuffer::MAX_CELLS_PER_SIDE || !RegionFile::slotFor(l.cells, slot)) continue;
+        if (!levels.empty()) {
+            const LodLevel& finer = levels.back();
+            if (l.cells >= finer.cells || (finer.cells - 1) % (l.cells - 1) != 0) continue;
+            if (l.distance <= finer.distance) continue;
+        }
+        levels.push_back(l);
+    }
+    if (levels.empty()) *this = LodChain();
+}
+
+LodChain LodChain::parse(const std::string& spec){
+    std::vector<LodLevel> out;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        LodLevel l;
+        char rest;
+        if (std::sscanf(item.c_str(), "%d:%f%c", &l.cells, &l.distance, &rest) == 2) out.push_back(l);
+    }
+    return LodChain(std::move(out));
+}
+
+LodChain LodChain::halving(int finestCells, int count, float firstDistance){
+    std::vector<LodLevel> out;
+    int cells = finestCells;
+    float distance = firstDistance;
+    for (int i = 0; i < count; ++i) {
+        out.push_back({cells, distance});
+        if (cells <= 3 || (cells - 1) % 2 != 0) break;
+        cells = (cells - 1) / 2 + 1;
+        distance *= 2.0f;
+    }
+    return LodChain(std::move(out));
+}
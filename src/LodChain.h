@@ -0,0 +1,45 @@
+#ifndef LOD_CHAIN_H
+#define LOD_CHAIN_H
+
+#include <string>
+#include <vector>
+
+// One level of detail of a chunk
+struct LodLevel {
+    int cells;       // vertices per chunk side
+    float distance;  // wanted up to this distance from the camera
+};
+
+// The chunk LOD levels, finest first. The last level's distance is the view
+// (load) distance. Grids nest, (finer - 1) being a multiple of (cells - 1),
+// so one noise pass at a level yields every coarser one by decimation.
+class LodChain {
+public:
+    // 65/33/17 out to 150/300/1050 units
+    LodChain();
+
+    // Levels that do not nest into the previous one or reach no further
+    // are dropped, as are grids the pipeline cannot hold: more than
+    // GridIndexBuffer::MAX_CELLS_PER_SIDE vertices, or no RegionFile slot
+    // (cells - 1 not a power of two up to 128). An empty list gives the
+    // default chain.
+    explicit LodChain(std::vector<LodLevel> levels);
+
+    // "cells:distance,cells:distance,...", finest first, e.g. from the
+    // command line; invalid levels are dropped as above
+    static LodChain parse(const std::string& spec);
+
+    // Up to `count` levels from finestCells, halving the grid (down to 3x3)
+    // and doubling the distance at each step
+    static LodChain halving(int finestCells, int count, float firstDistance);
+
+    int count() const { return static_cast<int>(levels.size()); }
+    int cells(int lod) const { return levels[lod].cells; }
+    float distance(int lod) const { return levels[lod].distance; }
+    float viewDistance() const { return levels.back().distance; }
+
+private:
+    std::vector<LodLevel> levels;
+};
+
+#endif
@@ -1,5 +1,6 @@
 
 #include "Mesh.h"
+#include "GridIndexBuffer.h"
 #include <glm/gtc/noise.hpp>
 
 
@@ -104,38 +105,33 @@ Mesh::Mesh(const std::vector<float>& vertices, const std::vector<unsigned>& indi
 
 
 Mesh::Mesh(const MeshData& meshData){
-    indexCount = meshData.indicesCount();
+    // Topology depends only on the grid size, bind the shared 16-bit buffer
+    const GridIndexBuffer& grid = GridIndexBuffer::get(meshData.cellsPerSide);
+    EBO = grid.EBO;
+    indexCount = grid.indexCount;
+    indexType = GL_UNSIGNED_SHORT;
+    ownsIndexBuffer = false;
 
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
 
     glBindVertexArray(VAO);
 
 
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, meshData.verticesCount() * sizeof(Vertex), meshData.vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, meshData.verticesCount() * sizeof(TerrainVertex), meshData.vertices.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshData.indicesCount() * sizeof(unsigned int), meshData.indices.data(), GL_STATIC_DRAW);
 
-    // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    // Quantized height, normalized to [0, 1]
+    glVertexAttribPointer(0, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, height));
     glEnableVertexAttribArray(0);
 
-    // Normal
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    // Octahedral normal, normalized to [-1, 1]
+    glVertexAttribPointer(1, 2, GL_BYTE, GL_TRUE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, normal));
     glEnableVertexAttribArray(1);
 
-    // Color
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-    glEnableVertexAttribArray(2);
-
-    // Texture
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-    glEnableVertexAttribArray(3);
-
     glBindVertexArray(0);
 }
 
@@ -143,14 +139,14 @@ Mesh::Mesh(const MeshData& meshData){
 Mesh::~Mesh(){
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    if(ownsIndexBuffer) glDeleteBuffers(1, &EBO);
 }
 
 
 void Mesh::draw(){
 
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
     glBindVertexArray(0);
 }
 
@@ -158,7 +154,7 @@ void Mesh::drawSolid(){
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
     glBindVertexArray(0);
 }
 
@@ -169,7 +165,7 @@ void Mesh::drawWireframe(){
     glLineWidth(1.0f);             // change thickness
 
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
     glBindVertexArray(0);
 
     glEnable(GL_CULL_FACE);
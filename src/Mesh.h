@@ -15,6 +15,8 @@ class Mesh{
 public:
     unsigned int VAO, VBO, EBO;
     unsigned int indexCount;
+    unsigned int indexType = GL_UNSIGNED_INT;
+    bool ownsIndexBuffer = true;  // false when EBO is a shared GridIndexBuffer
 
 
     Mesh(float* vertices, size_t vertSize, unsigned int* indices, size_t idxSize);
@@ -1,17 +1,62 @@
-
-
 #include "MeshData.h"
+#include <algorithm>
+#include <cmath>
 
 
 void MeshData::clear(){
     vertices.clear();
-    indices.clear();
 }
 
 size_t MeshData::verticesCount() const{
     return vertices.size();
 }
 
-size_t MeshData::indicesCount() const{
-    return indices.size();
-}
\ No newline at end of file
+float MeshData::heightAt(size_t index) const{
+    return heightMin + vertices[index].height * (heightRange / 65535.0f);
+}
+
+glm::vec3 MeshData::positionAt(size_t index) const{
+    int row = static_cast<int>(index / cellsPerSide);
+    int col = static_cast<int>(index % cellsPerSide);
+    return glm::vec3(originX + col * spacing, heightAt(index), originZ + row * spacing);
+}
+
+glm::vec3 MeshData::normalAt(size_t index) const{
+    return decodeNormal(vertices[index].normal);
+}
+
+uint16_t MeshData::quantizeHeight(float h) const{
+    if (heightRange <= 0.0f) return 0;
+    float t = (h - heightMin) / heightRange;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    return static_cast<uint16_t>(std::lround(t * 65535.0f));
+}
+
+// Octahedral mapping with y (up) as the fold axis, so the upward-facing
+// normals terrain mostly has land in the centre of the square
+void MeshData::encodeNormal(const glm::vec3& n, int8_t out[2]){
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float ex = n.x / l1;
+    float ez = n.z / l1;
+
+    if (n.y < 0.0f) {
+        float fx = (1.0f - std::fabs(ez)) * (ex >= 0.0f ? 1.0f : -1.0f);
+        float fz = (1.0f - std::fabs(ex)) * (ez >= 0.0f ? 1.0f : -1.0f);
+        ex = fx;
+        ez = fz;
+    }
+
+    out[0] = static_cast<int8_t>(std::lround(std::min(std::max(ex, -1.0f), 1.0f) * 127.0f));
+    out[1] = static_cast<int8_t>(std::lround(std::min(std::max(ez, -1.0f), 1.0f) * 127.0f));
+}
+
+glm::vec3 MeshData::decodeNormal(const int8_t in[2]){
+    float ex = std::max(in[0] / 127.0f, -1.0f);
+    float ez = std::max(in[1] / 127.0f, -1.0f);
+
+    glm::vec3 n(ex, 1.0f - std::fabs(ex) - std::fabs(ez), ez);
+    float t = std::max(-n.y, 0.0f);
+    n.x += (n.x >= 0.0f) ? -t : t;
+    n.z += (n.z >= 0.0f) ? -t : t;
+    return glm::normalize(n);
+}
@@ -2,6 +2,7 @@
 #define MESH_DATA_H
 
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
 
 struct Vertex{
@@ -11,16 +12,43 @@ struct Vertex{
     glm::vec2 texCoord;
 };
 
+// Packed terrain vertex (4 bytes instead of the 44 of Vertex). x/z are
+// implied by the grid and rebuilt from gl_VertexID in terrain.vert, color
+// comes from the height in terrain.frag.
+struct TerrainVertex{
+    uint16_t height;    // quantized over [heightMin, heightMin + heightRange]
+    int8_t normal[2];   // octahedral-encoded unit normal, snorm8
+};
+
 
 class MeshData{
 public:
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    std::vector<TerrainVertex> vertices;
+
+    // Grid the vertices are laid out on, row-major; the triangle list is
+    // shared per grid size (GridIndexBuffer)
+    int cellsPerSide = 0;
+    float originX = 0.0f;
+    float originZ = 0.0f;
+    float spacing = 1.0f;
+
+    // Height quantization range; shared by every chunk of a generator so
+    // edge vertices of neighbouring chunks decode to the same height
+    float heightMin = 0.0f;
+    float heightRange = 1.0f;
 
     void clear();
 
     size_t verticesCount() const;
-    size_t indicesCount() const;
+
+    float heightAt(size_t index) const;
+    glm::vec3 positionAt(size_t index) const;
+    glm::vec3 normalAt(size_t index) const;
+
+    uint16_t quantizeHeight(float h) const;
+
+    static void encodeNormal(const glm::vec3& n, int8_t out[2]);
+    static glm::vec3 decodeNormal(const int8_t in[2]);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,93 @@
+#include "MeshMemoryBudget.h"
+#include <algorithm>
+#include <numeric>
+
+size_t MeshMemoryBudget::Usage::cpuTotal() const{
+    return std::accumulate(cpuBytes.begin(), cpuBytes.end(), size_t(0));
+}
+
+size_t MeshMemoryBudget::Usage::gpuTotal() const{
+    return std::accumulate(gpuBytes.begin(), gpuBytes.end(), size_t(0));
+}
+
+MeshMemoryBudget::MeshMemoryBudget(int lodCount_, size_t cpuBudgetBytes, size_t gpuBudgetBytes)
+    : cpuBudget(cpuBudgetBytes), gpuBudget(gpuBudgetBytes), lodCount(lodCount_)
+{
+    current.cpuBytes.assign(lodCount, 0);
+    current.gpuBytes.assign(lodCount, 0);
+    current.cpuCopies.assign(lodCount, 0);
+    current.gpuMeshes.assign(lodCount, 0);
+}
+
+void MeshMemoryBudget::track(int lod, size_t cpuBytes, size_t gpuBytes){
+    if (lod < 0 || lod >= lodCount) return;
+
+    current.cpuBytes[lod] += cpuBytes;
+    current.gpuBytes[lod] += gpuBytes;
+    if (cpuBytes > 0) ++current.cpuCopies[lod];
+    if (gpuBytes > 0) ++current.gpuMeshes[lod];
+}
+
+void MeshMemoryBudget::untrack(int lod, size_t cpuBytes, size_t gpuBytes){
+    if (lod < 0 || lod >= lodCount) return;
+
+    current.cpuBytes[lod] -= cpuBytes;
+    current.gpuBytes[lod] -= gpuBytes;
+    if (cpuBytes > 0) --current.cpuCopies[lod];
+    if (gpuBytes > 0) --current.gpuMeshes[lod];
+}
+
+bool MeshMemoryBudget::overBudget() const{
+    return current.cpuTotal() > cpuBudget || current.gpuTotal() > gpuBudget;
+}
+
+MeshMemoryBudget::Usage MeshMemoryBudget::usage() const{
+    Usage u = current;
+    u.cpuBudget = cpuBudget;
+    u.gpuBudget = gpuBudget;
+    return u;
+}
+
+void MeshMemoryBudget::beginScan(){
+    residents.clear();
+}
+
+void MeshMemoryBudget::add(const Resident& r){
+    if (r.lod < 0 || r.lod >= lodCount) return;
+    residents.push_back(r);
+}
+
+float MeshMemoryBudget::score(const Resident& r){
+    return float(r.age + 1) * (1.0f + DISTANCE_WEIGHT * float(r.distance));
+}
+
+std::vector<MeshMemoryBudget::Eviction> MeshMemoryBudget::plan(){
+    std::vector<Eviction> out;
+    size_t cpu = current.cpuTotal();
+    size_t gpu = current.gpuTotal();
+    if (cpu <= cpuBudget && gpu <= gpuBudget) return out;
+
+    std::sort(residents.begin(), residents.end(),
+        [](const Resident& a, const Resident& b) { return score(a) > score(b); });
+
+    // Whole LODs first: each one frees its CPU copy too
+    std::vector<bool> evicted(residents.size(), false);
+    for (size_t i = 0; i < residents.size() && gpu > gpuBudget; ++i) {
+        const Resident& r = residents[i];
+        if (r.pinned || r.gpuBytes == 0) continue;
+
+        out.push_back(Eviction{r.key, r.lod, false});
+        evicted[i] = true;
+        gpu -= r.gpuBytes;
+        cpu -= r.cpuBytes;
+    }
+
+    for (size_t i = 0; i < residents.size() && cpu > cpuBudget; ++i) {
+        const Resident& r = residents[i];
+        if (evicted[i] || r.cpuBytes == 0) continue;
+
+        out.push_back(Eviction{r.key, r.lod, true});
+        cpu -= r.cpuBytes;
+    }
+    return out;
+}
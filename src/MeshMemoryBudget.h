@@ -0,0 +1,75 @@
+#ifndef MESH_MEMORY_BUDGET_H
+#define MESH_MEMORY_BUDGET_H
+
+#include "ChunkKey.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Accounting and eviction policy for resident chunk meshes, with separate
+// budgets for the CPU copies (MeshData kept after upload) and the GPU vertex
+// buffers. The owner keeps running totals through track()/untrack() as LODs
+// come and go. Only when over a budget does it report every resident LOD;
+// plan() then picks what to drop, least recently used and farthest first:
+//  - over the GPU budget, whole LODs (mesh and CPU copy), never pinned ones
+//  - over the CPU budget, CPU copies only; the mesh keeps drawing
+class MeshMemoryBudget {
+public:
+    struct Usage {
+        std::vector<size_t> cpuBytes, gpuBytes;      // per LOD
+        std::vector<uint32_t> cpuCopies, gpuMeshes;  // per LOD
+        size_t cpuBudget = 0, gpuBudget = 0;
+
+        size_t cpuTotal() const;
+        size_t gpuTotal() const;
+    };
+
+    struct Resident {
+        ChunkKey key;
+        int lod = 0;
+        size_t cpuBytes = 0;
+        size_t gpuBytes = 0;
+        uint64_t age = 0;    // frames since the LOD was last chosen for drawing
+        int distance = 0;    // chunk rings from the camera
+        bool pinned = false; // drawn or wanted right now
+    };
+
+    struct Eviction {
+        ChunkKey key;
+        int lod;
+        bool cpuOnly;  // release the CPU copy, keep the mesh
+    };
+
+    size_t cpuBudget;
+    size_t gpuBudget;
+
+    MeshMemoryBudget(int lodCount, size_t cpuBudgetBytes, size_t gpuBudgetBytes);
+
+    // A LOD's CPU copy and mesh appearing or going away; zero sizes count
+    // as absent
+    void track(int lod, size_t cpuBytes, size_t gpuBytes);
+    void untrack(int lod, size_t cpuBytes, size_t gpuBytes);
+
+    bool overBudget() const;
+
+    // Residents for plan(), reported only while over budget
+    void beginScan();
+    void add(const Resident& r);
+
+    // Evictions bringing both totals under budget where possible. usage()
+    // is unchanged: the owner untracks what it actually evicts.
+    std::vector<Eviction> plan();
+
+    Usage usage() const;
+
+private:
+    static constexpr float DISTANCE_WEIGHT = 0.5f;  // one ring counts as half the age again
+
+    int lodCount;
+    Usage current;
+    std::vector<Resident> residents;
+
+    static float score(const Resident& r);
+};
+
+#endif
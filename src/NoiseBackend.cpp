@@ -0,0 +1,198 @@
+#include "NoiseBackend.h"
+#include <glm/gtc/noise.hpp>
+#include <cmath>
+#include <random>
+
+namespace {
+    // Cast-based floor; valid for |x| < 2^31, which covers any reachable chunk
+    inline int fastFloor(float x){
+        int i = static_cast<int>(x);
+        return (x < static_cast<float>(i)) ? i - 1 : i;
+    }
+
+    inline float fade(float t){
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    // Unit gradients span about +-0.7, stretch to roughly [-1, 1]
+    constexpr float SEEDED_SCALE = 1.41421356f;
+
+    // Corner gradients of one lattice cell: x/z for 00, 10, 01, 11
+    struct CellGradients {
+        float g[8];
+    };
+
+    inline float evalCell(const CellGradients& c, float fx, float fz){
+        float n00 = c.g[0] * fx          + c.g[1] * fz;
+        float n10 = c.g[2] * (fx - 1.0f) + c.g[3] * fz;
+        float n01 = c.g[4] * fx          + c.g[5] * (fz - 1.0f);
+        float n11 = c.g[6] * (fx - 1.0f) + c.g[7] * (fz - 1.0f);
+
+        float u = fade(fx);
+        float v = fade(fz);
+        float nx0 = n00 + u * (n10 - n00);
+        float nx1 = n01 + u * (n11 - n01);
+        return SEEDED_SCALE * (nx0 + v * (nx1 - nx0));
+    }
+
+    class GlmNoiseBackend : public NoiseBackend {
+    public:
+        const char* name() const override { return "glm"; }
+        float noise(float x, float z) const override {
+            return glm::perlin(glm::vec2(x, z));
+        }
+    };
+
+    class SimdPerlinBackend : public NoiseBackend {
+    public:
+        const char* name() const override { return "simd-perlin"; }
+        float noise(float x, float z) const override {
+            return NoiseKernels::perlin(x, z);
+        }
+        void fractalHeights(const NoiseKernels::FractalParams& p, const float* xs, const float* zs, float* out, size_t n) const override {
+            NoiseKernels::fractalHeights(p, xs, zs, out, n);
+        }
+    };
+}
+
+const char* noiseTypeName(NoiseType type){
+    switch(type){
+        case NoiseType::Seeded:     return "seeded";
+        case NoiseType::SimdPerlin: return "simd-perlin";
+        case NoiseType::GlmPerlin:  return "glm";
+        default:                    return "unknown";
+    }
+}
+
+std::unique_ptr<NoiseBackend> createNoiseBackend(NoiseType type, unsigned int seed){
+    switch(type){
+        case NoiseType::SimdPerlin: return std::make_unique<SimdPerlinBackend>();
+        case NoiseType::GlmPerlin:  return std::make_unique<GlmNoiseBackend>();
+        default:                    return std::make_unique<SeededNoiseBackend>(seed);
+    }
+}
+
+void NoiseBackend::fractalHeights(const NoiseKernels::FractalParams& p, const float* xs, const float* zs, float* out, size_t n) const{
+    for(size_t i = 0; i < n; ++i){
+        float amplitude = 1.0f;
+        float frequency = p.baseFrequency;
+        float total = 0.0f;
+        float maxAmp = 0.0f;
+
+        for(int o = 0; o < p.octaves; ++o){
+            total += noise(xs[i] * frequency, zs[i] * frequency) * amplitude;
+            maxAmp += amplitude;
+            amplitude *= p.persistence;
+            frequency *= p.lacunarity;
+        }
+
+        if(maxAmp > 0.0f){
+            total /= maxAmp;
+        }
+        out[i] = total * p.heightScale;
+    }
+}
+
+float NoiseBackend::fractalHeight(const NoiseKernels::FractalParams& p, float x, float z) const{
+    float h;
+    fractalHeights(p, &x, &z, &h, 1);
+    return h;
+}
+
+SeededNoiseBackend::SeededNoiseBackend(unsigned int seed){
+    // Tables come straight from the mt19937 output, whose sequence the
+    // standard fixes, rather than through std:: distributions, whose
+    // results differ between standard libraries. The same seed then gives
+    // the same world (and matching cached heights) everywhere.
+    std::mt19937 rng(seed);
+
+    for(int i = 0; i < TABLE_SIZE; ++i){
+        perm[i] = static_cast<uint8_t>(i);
+    }
+    for(int i = TABLE_SIZE - 1; i > 0; --i){
+        // Rejection keeps the pick unbiased
+        const uint32_t range = uint32_t(i) + 1;
+        const uint32_t limit = uint32_t(0xffffffffu) - uint32_t(0xffffffffu) % range;
+        uint32_t r;
+        do { r = uint32_t(rng()); } while (r >= limit);
+        std::swap(perm[i], perm[r % range]);
+    }
+    for(int i = 0; i < TABLE_SIZE; ++i){
+        perm[TABLE_SIZE + i] = perm[i];
+    }
+
+    // 24-bit angles; evaluated in double and rounded so libm differences
+    // below float precision do not show
+    for(int i = 0; i < TABLE_SIZE; ++i){
+        double a = double(uint32_t(rng()) >> 8) * (6.283185307179586 / 16777216.0);
+        gradX[i] = static_cast<float>(std::cos(a));
+        gradZ[i] = static_cast<float>(std::sin(a));
+    }
+}
+
+float SeededNoiseBackend::noise(float x, float z) const{
+    int ix = fastFloor(x);
+    int iz = fastFloor(z);
+
+    CellGradients c;
+    int h00 = hash(ix, iz),     h10 = hash(ix + 1, iz);
+    int h01 = hash(ix, iz + 1), h11 = hash(ix + 1, iz + 1);
+    c.g[0] = gradX[h00]; c.g[1] = gradZ[h00];
+    c.g[2] = gradX[h10]; c.g[3] = gradZ[h10];
+    c.g[4] = gradX[h01]; c.g[5] = gradZ[h01];
+    c.g[6] = gradX[h11]; c.g[7] = gradZ[h11];
+
+    return evalCell(c, x - static_cast<float>(ix), z - static_cast<float>(iz));
+}
+
+void SeededNoiseBackend::fractalHeights(const NoiseKernels::FractalParams& p, const float* xs, const float* zs, float* out, size_t n) const{
+    for(size_t i = 0; i < n; ++i){
+        out[i] = 0.0f;
+    }
+
+    float amplitude = 1.0f;
+    float frequency = p.baseFrequency;
+    float maxAmp = 0.0f;
+
+    for(int o = 0; o < p.octaves; ++o){
+        // Chunk rows walk x at a fixed z, and at low octaves many samples
+        // share a lattice cell, so the corner gradients are only re-fetched
+        // when the cell changes
+        int cachedX = 0, cachedZ = 0;
+        bool cached = false;
+        CellGradients c = {};
+
+        for(size_t i = 0; i < n; ++i){
+            float x = xs[i] * frequency;
+            float z = zs[i] * frequency;
+            int ix = fastFloor(x);
+            int iz = fastFloor(z);
+
+            if(!cached || ix != cachedX || iz != cachedZ){
+                int h00 = hash(ix, iz),     h10 = hash(ix + 1, iz);
+                int h01 = hash(ix, iz + 1), h11 = hash(ix + 1, iz + 1);
+                c.g[0] = gradX[h00]; c.g[1] = gradZ[h00];
+                c.g[2] = gradX[h10]; c.g[3] = gradZ[h10];
+                c.g[4] = gradX[h01]; c.g[5] = gradZ[h01];
+                c.g[6] = gradX[h11]; c.g[7] = gradZ[h11];
+                cachedX = ix;
+                cachedZ = iz;
+                cached = true;
+            }
+
+            out[i] += evalCell(c, x - static_cast<float>(ix), z - static_cast<float>(iz)) * amplitude;
+        }
+
+        maxAmp += amplitude;
+        amplitude *= p.persistence;
+        frequency *= p.lacunarity;
+    }
+
+    for(size_t i = 0; i < n; ++i){
+        float total = out[i];
+        if(maxAmp > 0.0f){
+            total /= maxAmp;
+        }
+        out[i] = total * p.heightScale;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef NOISE_BACKEND_H
+#define NOISE_BACKEND_H
+
+#include "NoiseKernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum class NoiseType {
+    Seeded,      // permutation/gradient tables derived from Params::seed
+    SimdPerlin,  // batched SIMD port of glm::perlin (fixed hash, ignores seed)
+    GlmPerlin,   // glm::perlin per sample, reference only
+    Count
+};
+
+const char* noiseTypeName(NoiseType type);
+
+// Gradient noise source used by TerrainGenerator. Implementations are built
+// once per generator snapshot and must be safe to evaluate concurrently.
+class NoiseBackend {
+public:
+    virtual ~NoiseBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    // Single octave in roughly [-1, 1]
+    virtual float noise(float x, float z) const = 0;
+
+    // out[i] = fractal height at (xs[i], zs[i]). The default implementation
+    // sums noise() per octave; backends override it with faster batch paths.
+    virtual void fractalHeights(const NoiseKernels::FractalParams& p, const float* xs, const float* zs, float* out, size_t n) const;
+
+    float fractalHeight(const NoiseKernels::FractalParams& p, float x, float z) const;
+};
+
+std::unique_ptr<NoiseBackend> createNoiseBackend(NoiseType type, unsigned int seed);
+
+// 2D gradient noise over a 256-cell lattice whose permutation and gradient
+// tables are shuffled from the seed, so each seed yields a different world.
+// The pattern repeats every 256 lattice cells of the lowest octave.
+class SeededNoiseBackend : public NoiseBackend {
+public:
+    explicit SeededNoiseBackend(unsigned int seed);
+
+    const char* name() const override { return "seeded"; }
+    float noise(float x, float z) const override;
+    void fractalHeights(const NoiseKernels::FractalParams& p, const float* xs, const float* zs, float* out, size_t n) const override;
+
+private:
+    static constexpr int TABLE_SIZE = 256;
+    static constexpr int TABLE_MASK = TABLE_SIZE - 1;
+
+    uint8_t perm[TABLE_SIZE * 2];  // doubled to skip a wrap in the hash
+    float gradX[TABLE_SIZE];
+    float gradZ[TABLE_SIZE];
+
+    int hash(int ix, int iz) const { return perm[perm[ix & TABLE_MASK] + (iz & TABLE_MASK)]; }
+};
+
+#endif
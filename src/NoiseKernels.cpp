@@ -0,0 +1,87 @@
+#include "NoiseKernels.h"
+#include <cmath>
+
+namespace {
+    struct ScalarOps {
+        using Reg = float;
+        static constexpr size_t width = 1;
+
+        static Reg set1(float v) { return v; }
+        static Reg load(const float* p) { return *p; }
+        static void store(float* p, Reg v) { *p = v; }
+        static Reg add(Reg a, Reg b) { return a + b; }
+        static Reg sub(Reg a, Reg b) { return a - b; }
+        static Reg mul(Reg a, Reg b) { return a * b; }
+        static Reg div(Reg a, Reg b) { return a / b; }
+        static Reg floor(Reg a) { return std::floor(a); }
+        static Reg abs(Reg a) { return std::fabs(a); }
+    };
+
+    #include "NoiseKernelsImpl.inl"
+
+    NoiseKernels::BatchFn kernelFor(NoiseKernels::Isa isa){
+        switch(isa){
+            case NoiseKernels::Isa::SSE2:   return NoiseKernels::sse2Kernel();
+            case NoiseKernels::Isa::AVX2:   return NoiseKernels::avx2Kernel();
+            case NoiseKernels::Isa::AVX512: return NoiseKernels::avx512Kernel();
+            default: return &fractalBatchV<ScalarOps>;
+        }
+    }
+
+    bool cpuSupports(NoiseKernels::Isa isa){
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        switch(isa){
+            case NoiseKernels::Isa::SSE2:   return __builtin_cpu_supports("sse2");
+            case NoiseKernels::Isa::AVX2:   return __builtin_cpu_supports("avx2");
+            case NoiseKernels::Isa::AVX512: return __builtin_cpu_supports("avx512f");
+            default: return true;
+        }
+#else
+        return isa == NoiseKernels::Isa::Scalar;
+#endif
+    }
+}
+
+const char* NoiseKernels::isaName(Isa isa){
+    switch(isa){
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+        case Isa::AVX512: return "avx512";
+        default:          return "unknown";
+    }
+}
+
+bool NoiseKernels::isaSupported(Isa isa){
+    if(isa == Isa::Scalar) return true;
+    return kernelFor(isa) != nullptr && cpuSupports(isa);
+}
+
+NoiseKernels::Isa NoiseKernels::activeIsa(){
+    static const Isa best = []() {
+        const Isa order[] = { Isa::AVX512, Isa::AVX2, Isa::SSE2 };
+        for(Isa isa : order){
+            if(isaSupported(isa)) return isa;
+        }
+        return Isa::Scalar;
+    }();
+    return best;
+}
+
+void NoiseKernels::fractalHeights(const FractalParams& p, const float* xs, const float* zs, float* out, size_t n){
+    static const BatchFn fn = kernelFor(activeIsa());
+    fn(p, xs, zs, out, n);
+}
+
+void NoiseKernels::fractalHeights(Isa isa, const FractalParams& p, const float* xs, const float* zs, float* out, size_t n){
+    BatchFn fn = isaSupported(isa) ? kernelFor(isa) : kernelFor(Isa::Scalar);
+    fn(p, xs, zs, out, n);
+}
+
+float NoiseKernels::perlin(float x, float z){
+    return perlinV<ScalarOps>(x, z);
+}
+
+float NoiseKernels::fractalHeight(const FractalParams& p, float x, float z){
+    return fractalBlockV<ScalarOps>(p, x, z);
+}
@@ -0,0 +1,56 @@
+#ifndef NOISE_KERNELS_H
+#define NOISE_KERNELS_H
+
+#include <cstddef>
+
+// Batched fractal gradient noise. The vector paths are a lane-wise port of
+// glm::perlin(vec2) and perform exactly the same float operations in the
+// same order as the scalar path, so all ISAs return bit-identical heights
+// (this file and the per-ISA units are built with -ffp-contract=off).
+// Compared to glm::perlin itself results stay within a few ulp.
+//
+// The SSE2 path floors via a 32-bit truncation and is only exact for
+// |coordinate * frequency| < 2^31, far beyond any reachable chunk.
+namespace NoiseKernels {
+
+    enum class Isa {
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512,
+        Count
+    };
+
+    struct FractalParams {
+        float baseFrequency = 0.01f;
+        int octaves = 4;
+        float persistence = 0.5f;
+        float lacunarity = 2.0f;
+        float heightScale = 20.0f;
+    };
+
+    // out[i] = fractal height at (xs[i], zs[i])
+    using BatchFn = void (*)(const FractalParams& p, const float* xs, const float* zs, float* out, size_t n);
+
+    const char* isaName(Isa isa);
+
+    // Whether the ISA was compiled in and the running CPU supports it
+    bool isaSupported(Isa isa);
+
+    // Widest supported ISA, detected once
+    Isa activeIsa();
+
+    void fractalHeights(const FractalParams& p, const float* xs, const float* zs, float* out, size_t n);
+    void fractalHeights(Isa isa, const FractalParams& p, const float* xs, const float* zs, float* out, size_t n);
+
+    // Single-sample scalar reference
+    float perlin(float x, float z);
+    float fractalHeight(const FractalParams& p, float x, float z);
+
+    // Implemented by the per-ISA translation units, nullptr when not built
+    BatchFn sse2Kernel();
+    BatchFn avx2Kernel();
+    BatchFn avx512Kernel();
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include "NoiseKernels.h"
+
+// Built with -mavx2 (see CMakeLists.txt) and only entered after a runtime
+// CPU check, so nothing here may be called from generic code
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+    struct AVX2Ops {
+        using Reg = __m256;
+        static constexpr size_t width = 8;
+
+        static Reg set1(float v) { return _mm256_set1_ps(v); }
+        static Reg load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, Reg v) { _mm256_storeu_ps(p, v); }
+        static Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+        static Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+        static Reg mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+        static Reg div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+        static Reg floor(Reg a) { return _mm256_floor_ps(a); }
+        static Reg abs(Reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    };
+
+    #include "NoiseKernelsImpl.inl"
+}
+
+NoiseKernels::BatchFn NoiseKernels::avx2Kernel(){
+    return &fractalBatchV<AVX2Ops>;
+}
+
+#else
+
+NoiseKernels::BatchFn NoiseKernels::avx2Kernel(){
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include "NoiseKernels.h"
+
+// Built with -mavx512f (see CMakeLists.txt) and only entered after a
+// runtime CPU check, so nothing here may be called from generic code
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace {
+    struct AVX512Ops {
+        using Reg = __m512;
+        static constexpr size_t width = 16;
+
+        static Reg set1(float v) { return _mm512_set1_ps(v); }
+        static Reg load(const float* p) { return _mm512_loadu_ps(p); }
+        static void store(float* p, Reg v) { _mm512_storeu_ps(p, v); }
+        static Reg add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+        static Reg sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+        static Reg mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+        static Reg div(Reg a, Reg b) { return _mm512_div_ps(a, b); }
+        static Reg floor(Reg a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+        static Reg abs(Reg a) { return _mm512_abs_ps(a); }
+    };
+
+    #include "NoiseKernelsImpl.inl"
+}
+
+NoiseKernels::BatchFn NoiseKernels::avx512Kernel(){
+    return &fractalBatchV<AVX512Ops>;
+}
+
+#else
+
+NoiseKernels::BatchFn NoiseKernels::avx512Kernel(){
+    return nullptr;
+}
+
+#endif
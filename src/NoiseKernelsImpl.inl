@@ -0,0 +1,129 @@
+// Shared body of the batched noise kernels. Included inside an anonymous
+// namespace by NoiseKernels.cpp and the per-ISA translation units after
+// defining an ops struct V:
+//   V::Reg, V::width, set1, load, store, add, sub, mul, div, floor, abs
+// Do not include headers from here, the including unit owns the flags.
+
+template<class V>
+inline typename V::Reg fractV(typename V::Reg x){
+    return V::sub(x, V::floor(x));
+}
+
+template<class V>
+inline typename V::Reg mod289V(typename V::Reg x){
+    return V::sub(x, V::mul(V::floor(V::mul(x, V::set1(1.0f / 289.0f))), V::set1(289.0f)));
+}
+
+template<class V>
+inline typename V::Reg permuteV(typename V::Reg x){
+    return mod289V<V>(V::mul(V::add(V::mul(x, V::set1(34.0f)), V::set1(1.0f)), x));
+}
+
+template<class V>
+inline typename V::Reg fadeV(typename V::Reg t){
+    typename V::Reg t3 = V::mul(V::mul(t, t), t);
+    return V::mul(t3, V::add(V::mul(t, V::sub(V::mul(t, V::set1(6.0f)), V::set1(15.0f))), V::set1(10.0f)));
+}
+
+template<class V>
+inline typename V::Reg mixV(typename V::Reg a, typename V::Reg b, typename V::Reg t){
+    return V::add(V::mul(a, V::sub(V::set1(1.0f), t)), V::mul(b, t));
+}
+
+// Gradient contribution of one lattice corner, matching glm's ordering
+template<class V>
+inline typename V::Reg cornerV(typename V::Reg ix, typename V::Reg iy, typename V::Reg fx, typename V::Reg fy){
+    typename V::Reg i = permuteV<V>(V::add(permuteV<V>(ix), iy));
+
+    typename V::Reg gx = V::sub(V::mul(V::set1(2.0f), fractV<V>(V::div(i, V::set1(41.0f)))), V::set1(1.0f));
+    typename V::Reg gy = V::sub(V::abs(gx), V::set1(0.5f));
+    typename V::Reg tx = V::floor(V::add(gx, V::set1(0.5f)));
+    gx = V::sub(gx, tx);
+
+    typename V::Reg lenSq = V::add(V::mul(gx, gx), V::mul(gy, gy));
+    typename V::Reg norm = V::sub(V::set1(1.79284291400159f), V::mul(V::set1(0.85373472095314f), lenSq));
+    gx = V::mul(gx, norm);
+    gy = V::mul(gy, norm);
+
+    return V::add(V::mul(gx, fx), V::mul(gy, fy));
+}
+
+template<class V>
+inline typename V::Reg perlinV(typename V::Reg x, typename V::Reg z){
+    typename V::Reg floorX = V::floor(x);
+    typename V::Reg floorZ = V::floor(z);
+
+    typename V::Reg pfx = V::sub(x, floorX);
+    typename V::Reg pfz = V::sub(z, floorZ);
+    typename V::Reg pfx1 = V::sub(pfx, V::set1(1.0f));
+    typename V::Reg pfz1 = V::sub(pfz, V::set1(1.0f));
+
+    // mod(Pi, 289) keeps the permutation polynomial exact in float
+    typename V::Reg m = V::set1(289.0f);
+    typename V::Reg pix  = V::add(floorX, V::set1(0.0f));
+    typename V::Reg piz  = V::add(floorZ, V::set1(0.0f));
+    typename V::Reg pix1 = V::add(floorX, V::set1(1.0f));
+    typename V::Reg piz1 = V::add(floorZ, V::set1(1.0f));
+    pix  = V::sub(pix,  V::mul(m, V::floor(V::div(pix,  m))));
+    piz  = V::sub(piz,  V::mul(m, V::floor(V::div(piz,  m))));
+    pix1 = V::sub(pix1, V::mul(m, V::floor(V::div(pix1, m))));
+    piz1 = V::sub(piz1, V::mul(m, V::floor(V::div(piz1, m))));
+
+    typename V::Reg n00 = cornerV<V>(pix,  piz,  pfx,  pfz);
+    typename V::Reg n10 = cornerV<V>(pix1, piz,  pfx1, pfz);
+    typename V::Reg n01 = cornerV<V>(pix,  piz1, pfx,  pfz1);
+    typename V::Reg n11 = cornerV<V>(pix1, piz1, pfx1, pfz1);
+
+    typename V::Reg fadeX = fadeV<V>(pfx);
+    typename V::Reg fadeZ = fadeV<V>(pfz);
+
+    typename V::Reg nx0 = mixV<V>(n00, n10, fadeX);
+    typename V::Reg nx1 = mixV<V>(n01, n11, fadeX);
+    return V::mul(V::set1(2.3f), mixV<V>(nx0, nx1, fadeZ));
+}
+
+template<class V>
+inline typename V::Reg fractalBlockV(const NoiseKernels::FractalParams& p, typename V::Reg x, typename V::Reg z){
+    typename V::Reg total = V::set1(0.0f);
+    float amplitude = 1.0f;
+    float frequency = p.baseFrequency;
+    float maxAmp = 0.0f;
+
+    for(int o = 0; o < p.octaves; ++o){
+        typename V::Reg f = V::set1(frequency);
+        typename V::Reg n = perlinV<V>(V::mul(x, f), V::mul(z, f));
+
+        total = V::add(total, V::mul(n, V::set1(amplitude)));
+        maxAmp += amplitude;
+        amplitude *= p.persistence;
+        frequency *= p.lacunarity;
+    }
+
+    if(maxAmp > 0.0f){
+        total = V::div(total, V::set1(maxAmp)); // normalize to [-1,1]
+    }
+    return V::mul(total, V::set1(p.heightScale));
+}
+
+template<class V>
+void fractalBatchV(const NoiseKernels::FractalParams& p, const float* xs, const float* zs, float* out, size_t n){
+    size_t i = 0;
+    for(; i + V::width <= n; i += V::width){
+        V::store(out + i, fractalBlockV<V>(p, V::load(xs + i), V::load(zs + i)));
+    }
+
+    if(i < n){
+        // Pad the tail to a full register; lanes are independent
+        float tx[V::width] = {};
+        float tz[V::width] = {};
+        float th[V::width];
+        for(size_t k = i; k < n; ++k){
+            tx[k - i] = xs[k];
+            tz[k - i] = zs[k];
+        }
+        V::store(th, fractalBlockV<V>(p, V::load(tx), V::load(tz)));
+        for(size_t k = i; k < n; ++k){
+            out[k] = th[k - i];
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#include "NoiseKernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+namespace {
+    struct SSE2Ops {
+        using Reg = __m128;
+        static constexpr size_t width = 4;
+
+        static Reg set1(float v) { return _mm_set1_ps(v); }
+        static Reg load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, Reg v) { _mm_storeu_ps(p, v); }
+        static Reg add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+        static Reg sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+        static Reg mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+        static Reg div(Reg a, Reg b) { return _mm_div_ps(a, b); }
+        static Reg abs(Reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+        // No roundps before SSE4.1: truncate, then step down for negatives
+        static Reg floor(Reg a) {
+            Reg t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+            Reg fix = _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f));
+            return _mm_sub_ps(t, fix);
+        }
+    };
+
+    #include "NoiseKernelsImpl.inl"
+}
+
+NoiseKernels::BatchFn NoiseKernels::sse2Kernel(){
+    return &fractalBatchV<SSE2Ops>;
+}
+
+#else
+
+NoiseKernels::BatchFn NoiseKernels::sse2Kernel(){
+    return nullptr;
+}
+
+#endif
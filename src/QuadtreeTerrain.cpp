@@ -0,0 +1,281 @@
+#include "QuadtreeTerrain.h"
+#include "TerrainChunk.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float distanceToBox(const glm::vec3& p, const glm::vec3& minB, const glm::vec3& maxB){
+    glm::vec3 d = glm::max(glm::max(minB - p, p - maxB), glm::vec3(0.0f));
+    return glm::length(d);
+}
+
+}
+
+QuadtreeTerrain::QuadtreeTerrain(TerrainGenerator& generator_, ThreadPool& jobPool_, float worldScale_, int levels_,
+                                 float lodDistance)
+    : generator(generator_), jobPool(jobPool_), worldScale(worldScale_), levels(std::max(levels_, 1))
+{
+    float range = lodDistance;
+    for (int l = 0; l < levels; ++l) {
+        ranges.push_back(range);
+        range *= 2.0f;
+    }
+    stats.drawnPerLevel.assign(levels, 0);
+    stats.viewDistance = ranges.back();
+}
+
+QuadtreeTerrain::~QuadtreeTerrain(){
+    // Jobs only hold the snapshot, so they may finish after this
+    for (auto& it : nodes) releaseNode(it.second);
+    nodes.clear();
+}
+
+float QuadtreeTerrain::nodeSize(int level) const{
+    return (HIGH_LOD_CELLS - 1) * worldScale * float(1 << level);
+}
+
+void QuadtreeTerrain::nodeBox(const NodeKey& key, glm::vec3& minB, glm::vec3& maxB) const{
+    auto it = nodes.find(key);
+    if (it != nodes.end() && it->second.mesh) {
+        minB = it->second.minBounds;
+        maxB = it->second.maxBounds;
+        return;
+    }
+
+    // No mesh yet: the whole quantized height range
+    const float size = nodeSize(key.level);
+    minB = glm::vec3(key.x * size, heightLo, key.z * size);
+    maxB = glm::vec3((key.x + 1) * size, heightHi, (key.z + 1) * size);
+}
+
+bool QuadtreeTerrain::ready(const NodeKey& key) const{
+    auto it = nodes.find(key);
+    return it != nodes.end() && it->second.mesh != nullptr;
+}
+
+void QuadtreeTerrain::want(const NodeKey& key, float priority){
+    Node& node = nodes[key];
+    node.lastUsedFrame = frame;
+    if (node.pending || node.hasUpload) return;
+
+    // Missing, or from older generator parameters (the old mesh keeps
+    // drawing until the new one is uploaded)
+    if (!node.mesh || node.generatorVersion != generator.getVersion()) {
+        requests.push_back({key, priority});
+    }
+}
+
+void QuadtreeTerrain::update(float, const Camera&){
+    collectJobs();
+
+    for (int n = 0; n < MAX_UPLOADS_PER_FRAME && !uploadKeys.empty(); ++n) {
+        NodeKey key = uploadKeys.front();
+        uploadKeys.erase(uploadKeys.begin());
+
+        auto it = nodes.find(key);
+        if (it == nodes.end() || !it->second.hasUpload) continue;
+
+        Node& node = it->second;
+        delete node.mesh;
+        node.hasUpload = false;
+        node.placement = std::move(node.ready);
+        node.ready = MeshData();
+        TerrainChunk::computeBounds(node.placement, node.minBounds, node.maxBounds);
+        node.mesh = new Mesh(node.placement);
+        node.gpuBytes = node.placement.verticesCount() * sizeof(TerrainVertex);
+
+        if (!node.heights) glGenTextures(1, &node.heights);
+        glBindTexture(GL_TEXTURE_BUFFER, node.heights);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R16, node.mesh->VBO);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        node.generatorVersion = node.jobVersion;
+
+        // Drawing only needs the grid placement
+        std::vector<TerrainVertex>().swap(node.placement.vertices);
+    }
+
+    issueRequests();
+    evictIdle();
+}
+
+void QuadtreeTerrain::collectJobs(){
+    for (auto& it : nodes) {
+        Node& node = it.second;
+        if (!node.pending || !node.job.poll()) continue;
+
+        MeshData data = node.job.take();
+        node.pending = false;
+
+        // Cancelled, or generated from parameters that changed since
+        if (data.vertices.empty() || node.jobVersion != generator.getVersion()) continue;
+
+        node.ready = std::move(data);
+        node.hasUpload = true;
+        uploadKeys.push_back(it.first);
+        ++stats.generatedNodes;
+    }
+}
+
+void QuadtreeTerrain::issueRequests(){
+    // Coarse nodes first, so every area has something to draw
+    std::sort(requests.begin(), requests.end(),
+        [](const Request& a, const Request& b) { return a.priority > b.priority; });
+
+    int issued = 0;
+    for (const Request& r : requests) {
+        if (issued >= MAX_NEW_REQUESTS_PER_FRAME) break;
+
+        auto it = nodes.find(r.key);
+        if (it == nodes.end()) continue;
+        Node& node = it->second;
+        if (node.pending || node.hasUpload) continue;
+
+        TerrainGenerator::SnapshotPtr gen = generator.snapshot();
+        const float size = nodeSize(r.key.level);
+        const float originX = r.key.x * size;
+        const float originZ = r.key.z * size;
+        const int cells = NODE_CELLS;
+
+        node.cancel = CancelToken();
+        CancelToken token = node.cancel;
+        node.job = jobPool.submit([gen, originX, originZ, size, cells, token]() {
+            HeightGrid grid = gen->generateRegionHeights(originX, originZ, size, cells, token.flag());
+            if (grid.empty()) return MeshData();
+            return gen->buildRegionMesh(originX, originZ, size, grid);
+        }, r.priority, token);
+        node.jobVersion = gen->getVersion();
+        node.pending = true;
+        stats.noiseSamples += uint64_t(cells + 2) * uint64_t(cells + 2);
+        ++issued;
+    }
+    requests.clear();
+}
+
+void QuadtreeTerrain::evictIdle(){
+    stats.residentNodes = 0;
+    stats.pendingNodes = 0;
+    stats.gpuBytes = 0;
+
+    for (auto it = nodes.begin(); it != nodes.end();) {
+        Node& node = it->second;
+        if (frame - std::min(frame, node.lastUsedFrame) > NODE_IDLE_FRAMES) {
+            if (node.mesh) ++stats.evictedNodes;
+            releaseNode(node);
+            it = nodes.erase(it);
+            continue;
+        }
+
+        if (node.mesh) {
+            ++stats.residentNodes;
+            stats.gpuBytes += node.gpuBytes;
+        }
+        if (node.pending) ++stats.pendingNodes;
+        ++it;
+    }
+}
+
+void QuadtreeTerrain::releaseNode(Node& node){
+    if (node.pending) node.cancel.cancel();
+    delete node.mesh;
+    node.mesh = nullptr;
+    if (node.heights) glDeleteTextures(1, &node.heights);
+    node.heights = 0;
+}
+
+void QuadtreeTerrain::draw(const Shader& shader, const Frustum& f, glm::vec3 cameraPos, bool wireframe){
+    ++frame;
+    stats.drawnNodes = 0;
+    stats.culledSubtrees = 0;
+    std::fill(stats.drawnPerLevel.begin(), stats.drawnPerLevel.end(), 0);
+
+    TerrainGenerator::SnapshotPtr gen = generator.snapshot();
+    heightLo = gen->heightMin();
+    heightHi = gen->heightMin() + gen->heightRange();
+
+    glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("uVertexHeights", 0);
+    shader.setVec3("uCameraPos", cameraPos);
+
+    // Every root node within the view distance of the camera
+    const int top = levels - 1;
+    const float rootSize = nodeSize(top);
+    const float view = ranges[top];
+    const int x0 = int(std::floor((cameraPos.x - view) / rootSize));
+    const int x1 = int(std::floor((cameraPos.x + view) / rootSize));
+    const int z0 = int(std::floor((cameraPos.z - view) / rootSize));
+    const int z1 = int(std::floor((cameraPos.z + view) / rootSize));
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            NodeKey root{top, x, z};
+            glm::vec3 minB, maxB;
+            nodeBox(root, minB, maxB);
+            if (distanceToBox(cameraPos, minB, maxB) > view) continue;
+            select(root, f, cameraPos, shader);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    shader.setFloat("uMorphEnd", 0.0f);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+}
+
+void QuadtreeTerrain::select(const NodeKey& key, const Frustum& f, const glm::vec3& cameraPos, const Shader& shader){
+    glm::vec3 minB, maxB;
+    nodeBox(key, minB, maxB);
+    if (!isInFrustum(f, minB, maxB)) {
+        ++stats.culledSubtrees;
+        return;
+    }
+
+    // Coarser levels first, then nearer nodes within a level
+    const float distance = distanceToBox(cameraPos, minB, maxB);
+    want(key, float(key.level) + 1.0f / (1.0f + distance / nodeSize(key.level)));
+
+    // Split while the camera is within range of the next finer level;
+    // the children replace this node only once all four can be drawn, or
+    // when there is nothing to draw here anyway
+    bool split = key.level > 0 && distance <= ranges[key.level - 1];
+    if (split) {
+        NodeKey children[4];
+        bool childrenReady = true;
+        for (int i = 0; i < 4; ++i) {
+            children[i] = NodeKey{key.level - 1, key.x * 2 + (i & 1), key.z * 2 + (i >> 1)};
+            childrenReady = childrenReady && ready(children[i]);
+        }
+        if (childrenReady || !ready(key)) {
+            for (const NodeKey& child : children) select(child, f, cameraPos, shader);
+            return;
+        }
+        for (const NodeKey& child : children) {
+            glm::vec3 cMin, cMax;
+            nodeBox(child, cMin, cMax);
+            want(child, float(child.level) + 1.0f / (1.0f + distanceToBox(cameraPos, cMin, cMax) / nodeSize(child.level)));
+        }
+    }
+
+    auto it = nodes.find(key);
+    if (it == nodes.end() || !it->second.mesh) return;
+    drawNode(shader, key, it->second);
+    ++stats.drawnNodes;
+    ++stats.drawnPerLevel[key.level];
+}
+
+void QuadtreeTerrain::drawNode(const Shader& shader, const NodeKey& key, const Node& node){
+    // A node is drawn up to its level's range; the coarsest level has
+    // nothing to morph into
+    const bool coarsest = key.level == levels - 1;
+    shader.setFloat("uMorphStart", MORPH_START * ranges[key.level]);
+    shader.setFloat("uMorphEnd", coarsest ? 0.0f : ranges[key.level]);
+    glBindTexture(GL_TEXTURE_BUFFER, node.heights);
+
+    // Same packed vertex layout and shader as a chunk, larger spacing
+    const MeshData& p = node.placement;
+    shader.setVec2("uChunkOrigin", glm::vec2(p.originX, p.originZ));
+    shader.setFloat("uCellSpacing", p.spacing);
+    shader.setInt("uCellsPerSide", p.cellsPerSide);
+    shader.setFloat("uHeightMin", p.heightMin);
+    shader.setFloat("uHeightRange", p.heightRange);
+    node.mesh->draw();
+}
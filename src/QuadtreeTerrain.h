@@ -0,0 +1,126 @@
+#ifndef QUADTREE_TERRAIN_H
+#define QUADTREE_TERRAIN_H
+
+#include "Camera.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "TerrainGenerator.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Alternative to Terrain's uniform chunk grid: a quadtree of square nodes,
+// CDLOD style. A node at level l covers 2^l chunks per side with the same
+// NODE_CELLS x NODE_CELLS grid, and is split while the camera is within
+// the range of the level below (lodDistance * 2^(l-1)), so node size
+// doubles with distance. Far terrain is covered by a few large nodes and
+// resident nodes grow with the log of the view distance. Subtrees outside
+// the frustum are skipped at their root. Vertices geomorph into the next
+// coarser level's surface over the outer part of their level's range.
+class QuadtreeTerrain {
+public:
+    struct Stats {
+        size_t residentNodes = 0;    // nodes with a mesh
+        size_t pendingNodes = 0;     // node jobs in flight
+        size_t drawnNodes = 0;       // last frame
+        size_t culledSubtrees = 0;   // last frame, rejected at their root
+        std::vector<uint32_t> drawnPerLevel;
+        uint64_t generatedNodes = 0;
+        uint64_t evictedNodes = 0;
+        uint64_t noiseSamples = 0;
+        size_t gpuBytes = 0;         // vertex buffers of resident nodes
+        float viewDistance = 0.0f;
+    };
+
+    // levels: node sizes from one chunk up to 2^(levels - 1) chunks;
+    // lodDistance: range of the finest level, doubled per level
+    QuadtreeTerrain(TerrainGenerator& generator, ThreadPool& jobPool, float worldScale, int levels = 8,
+                    float lodDistance = 150.0f);
+    ~QuadtreeTerrain();
+
+    void update(float dt, const Camera& camera);
+    void draw(const Shader& shader, const Frustum& f, glm::vec3 cameraPos, bool wireframe);
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct NodeKey {
+        int level;
+        int x, z;  // in nodes of this level
+
+        bool operator==(const NodeKey& o) const { return level == o.level && x == o.x && z == o.z; }
+    };
+
+    struct NodeKeyHash {
+        size_t operator()(const NodeKey& k) const {
+            uint64_t h = (uint64_t(uint32_t(k.x)) << 32) | uint32_t(k.z);
+            h ^= uint64_t(k.level) * 0x9e3779b97f4a7c15ULL;
+            h ^= h >> 33; h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+            h ^= h >> 31;
+            return size_t(h);
+        }
+    };
+
+    struct Node {
+        Mesh* mesh = nullptr;     // owned
+        GLuint heights = 0;       // GL_R16 buffer texture over the mesh's vertex buffer, for the morph
+        MeshData placement;       // grid placement of the mesh, vertices released after upload
+        glm::vec3 minBounds = glm::vec3(0.0f);
+        glm::vec3 maxBounds = glm::vec3(0.0f);
+        uint64_t generatorVersion = 0;
+        size_t gpuBytes = 0;
+
+        JobHandle<MeshData> job;
+        CancelToken cancel;
+        uint64_t jobVersion = 0;
+        bool pending = false;
+        bool hasUpload = false;   // job result waiting in `ready`
+        MeshData ready;
+
+        uint64_t lastUsedFrame = 0;
+    };
+
+    struct Request {
+        NodeKey key;
+        float priority;
+    };
+
+    static constexpr int NODE_CELLS = HIGH_LOD_CELLS;
+    static constexpr int MAX_NEW_REQUESTS_PER_FRAME = 16;
+    static constexpr int MAX_UPLOADS_PER_FRAME = 8;
+    static constexpr uint64_t NODE_IDLE_FRAMES = 300;  // unused this long: evicted
+    static constexpr float MORPH_START = 0.7f;  // fraction of a level's range where the morph begins
+
+    TerrainGenerator& generator;
+    ThreadPool& jobPool;
+    float worldScale;
+    int levels;
+    std::vector<float> ranges;  // per level
+
+    std::unordered_map<NodeKey, Node, NodeKeyHash> nodes;
+    std::vector<Request> requests;  // collected by draw(), issued by update()
+    std::vector<NodeKey> uploadKeys;  // finished jobs, oldest first
+    uint64_t frame = 0;
+    float heightLo = 0.0f, heightHi = 0.0f;  // bounds of nodes without a mesh, set per draw
+
+    Stats stats;
+
+    float nodeSize(int level) const;
+    void nodeBox(const NodeKey& key, glm::vec3& minB, glm::vec3& maxB) const;
+    bool ready(const NodeKey& key) const;
+    void want(const NodeKey& key, float priority);  // keeps the node, requests a mesh if it has none
+
+    // Draws the node, or its children once all four have a mesh, and
+    // requests whatever the selection is missing
+    void select(const NodeKey& key, const Frustum& f, const glm::vec3& cameraPos, const Shader& shader);
+    void drawNode(const Shader& shader, const NodeKey& key, const Node& node);
+
+    void collectJobs();
+    void issueRequests();
+    void evictIdle();
+    void releaseNode(Node& node);
+};
+
+#endif
@@ -0,0 +1,468 @@
+#include "RegionFile.h"
+#include "HeightCodec.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char MAGIC[4] = {'T', 'R', 'G', 'N'};
+    constexpr uint32_t FORMAT_VERSION = 2;
+
+    struct RegionHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t paramsHash;
+        int32_t regionX, regionZ;
+        uint64_t reserved;
+    };
+
+    constexpr size_t INDEX_ENTRIES = size_t(RegionFile::REGION_SIDE) * RegionFile::REGION_SIDE * RegionFile::SLOTS_PER_CHUNK;
+    constexpr size_t INDEX_OFFSET = sizeof(RegionHeader);
+    constexpr size_t HEADER_BYTES = INDEX_OFFSET + INDEX_ENTRIES * sizeof(uint64_t);
+
+    // Index entry: payload offset in the upper 40 bits, size in the lower
+    // 24, zero when empty. One word, so publishing is a single store.
+    constexpr int SIZE_BITS = 24;
+    constexpr uint64_t MAX_PAYLOAD = (uint64_t(1) << SIZE_BITS) - 1;
+    constexpr uint64_t MAX_OFFSET = (uint64_t(1) << (64 - SIZE_BITS)) - 1;
+
+    inline uint64_t packEntry(uint64_t offset, uint64_t size) { return (offset << SIZE_BITS) | size; }
+    inline uint64_t entryOffset(uint64_t entry) { return entry >> SIZE_BITS; }
+    inline uint64_t entrySize(uint64_t entry) { return entry & MAX_PAYLOAD; }
+
+    // Payload: this header, then the HeightCodec encoding of the
+    // stride x stride grid
+    struct PayloadHeader {
+        int32_t chunkX, chunkZ;
+        int32_t cellsPerSide;
+        int32_t apron;
+    };
+
+    constexpr uint64_t PAYLOAD_ALIGN = 8;
+
+    inline uint64_t alignUp(uint64_t v) { return (v + PAYLOAD_ALIGN - 1) & ~(PAYLOAD_ALIGN - 1); }
+
+    // The index is read and published in place through the mapping
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "index entries must be plain 64-bit words");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "index entries must be lock-free");
+    static_assert(INDEX_OFFSET % alignof(std::atomic<uint64_t>) == 0, "index must be aligned");
+}
+
+// Thin file handle; the POSIX and Win32 paths differ only here and in Mapping
+struct RegionFile::Platform {
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+
+    ~Platform(){
+        if(handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+    }
+
+    bool open(const std::string& path, bool create){
+        handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+            create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return handle != INVALID_HANDLE_VALUE;
+    }
+
+    uint64_t size() const{
+        LARGE_INTEGER s;
+        return GetFileSizeEx(handle, &s) ? uint64_t(s.QuadPart) : 0;
+    }
+
+    bool writeAt(uint64_t offset, const uint8_t* data, size_t bytes){
+        while(bytes > 0){
+            DWORD chunk = DWORD(std::min<size_t>(bytes, 1u << 30));
+            OVERLAPPED ov = {};
+            ov.Offset = DWORD(offset & 0xffffffffu);
+            ov.OffsetHigh = DWORD(offset >> 32);
+            DWORD written = 0;
+            if(!WriteFile(handle, data, chunk, &written, &ov) || written == 0) return false;
+            data += written;
+            offset += written;
+            bytes -= written;
+        }
+        return true;
+    }
+#else
+    int fd = -1;
+
+    ~Platform(){
+        if(fd >= 0) ::close(fd);
+    }
+
+    bool open(const std::string& path, bool create){
+        fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+        return fd >= 0;
+    }
+
+    uint64_t size() const{
+        struct stat st;
+        return fstat(fd, &st) == 0 ? uint64_t(st.st_size) : 0;
+    }
+
+    bool writeAt(uint64_t offset, const uint8_t* data, size_t bytes){
+        while(bytes > 0){
+            ssize_t n = ::pwrite(fd, data, bytes, off_t(offset));
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            data += n;
+            offset += uint64_t(n);
+            bytes -= size_t(n);
+        }
+        return true;
+    }
+#endif
+};
+
+// Read/write shared view of the first `length` bytes. Views are immutable
+// once created; a longer one replaces the old, which stays valid for the
+// readers still holding it.
+struct RegionFile::Mapping {
+    uint8_t* base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE section = nullptr;
+#endif
+
+    ~Mapping(){
+#ifdef _WIN32
+        if(base) UnmapViewOfFile(base);
+        if(section) CloseHandle(section);
+#else
+        if(base) munmap(base, length);
+#endif
+    }
+
+    static std::shared_ptr<const Mapping> create(const Platform& file, size_t length){
+        auto m = std::make_shared<Mapping>();
+#ifdef _WIN32
+        m->section = CreateFileMappingA(file.handle, nullptr, PAGE_READWRITE,
+            DWORD(uint64_t(length) >> 32), DWORD(length & 0xffffffffu), nullptr);
+        if(!m->section) return nullptr;
+        m->base = static_cast<uint8_t*>(MapViewOfFile(m->section, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, length));
+        if(!m->base) return nullptr;
+#else
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+        if(p == MAP_FAILED) return nullptr;
+        m->base = static_cast<uint8_t*>(p);
+#endif
+        m->length = length;
+        return m;
+    }
+
+    std::atomic<uint64_t>* index() const { return reinterpret_cast<std::atomic<uint64_t>*>(base + INDEX_OFFSET); }
+};
+
+RegionFile::RegionFile()
+    : file(std::make_unique<Platform>())
+{
+}
+
+RegionFile::~RegionFile() = default;
+
+std::shared_ptr<RegionFile> RegionFile::open(const std::string& path, uint64_t paramsHash, int regionX, int regionZ, bool create){
+    std::error_code ec;
+    if(!create && !std::filesystem::exists(path, ec)) return nullptr;
+    if(create){
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    }
+
+    std::shared_ptr<RegionFile> region(new RegionFile());
+    if(!region->file->open(path, create)) return nullptr;
+
+    uint64_t size = region->file->size();
+    if(size == 0 && create){
+        // Fresh file: header with an empty index
+        std::vector<uint8_t> header(HEADER_BYTES, 0);
+        RegionHeader h = {};
+        std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = FORMAT_VERSION;
+        h.paramsHash = paramsHash;
+        h.regionX = regionX;
+        h.regionZ = regionZ;
+        std::memcpy(header.data(), &h, sizeof(h));
+        if(!region->file->writeAt(0, header.data(), header.size())) return nullptr;
+        size = HEADER_BYTES;
+    }
+    if(size < HEADER_BYTES) return nullptr;
+
+    region->mapping = Mapping::create(*region->file, size_t(size));
+    if(!region->mapping) return nullptr;
+
+    RegionHeader h;
+    std::memcpy(&h, region->mapping->base, sizeof(h));
+    bool ok = std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0
+        && h.version == FORMAT_VERSION
+        && h.paramsHash == paramsHash
+        && h.regionX == regionX && h.regionZ == regionZ;
+    if(!ok) return nullptr;
+
+    region->paramsHash = paramsHash;
+    region->regionX = regionX;
+    region->regionZ = regionZ;
+    region->fileEnd = alignUp(size);
+    return region;
+}
+
+int RegionFile::regionCoord(int chunkCoord){
+    return chunkCoord >= 0 ? chunkCoord / REGION_SIDE : (chunkCoord - (REGION_SIDE - 1)) / REGION_SIDE;
+}
+
+int RegionFile::localCoord(int chunkCoord){
+    return chunkCoord - regionCoord(chunkCoord) * REGION_SIDE;
+}
+
+bool RegionFile::slotFor(int cellsPerSide, int& slot){
+    int n = cellsPerSide - 1;
+    if(n <= 0 || (n & (n - 1)) != 0) return false;
+
+    slot = 0;
+    while((1 << slot) < n) ++slot;
+    return slot < SLOTS_PER_CHUNK;
+}
+
+size_t RegionFile::indexFor(int cx, int cz, int slot){
+    return (size_t(localCoord(cz)) * REGION_SIDE + size_t(localCoord(cx))) * SLOTS_PER_CHUNK + size_t(slot);
+}
+
+std::shared_ptr<const RegionFile::Mapping> RegionFile::currentMapping() const{
+    return std::atomic_load(&mapping);
+}
+
+std::shared_ptr<const RegionFile::Mapping> RegionFile::mappingCovering(uint64_t end) const{
+    std::lock_guard<std::mutex> lock(remapMutex);
+
+    std::shared_ptr<const Mapping> m = currentMapping();
+    if(m->length >= end) return m;
+
+    // The payload was written before its entry was published, so the file
+    // is already long enough
+    uint64_t size = file->size();
+    if(size < end) return nullptr;
+
+    std::shared_ptr<const Mapping> longer = Mapping::create(*file, size_t(size));
+    if(!longer) return nullptr;
+    std::atomic_store(&mapping, longer);
+    return longer;
+}
+
+bool RegionFile::locate(int cx, int cz, int cellsPerSide, uint64_t& offset, uint32_t& size) const{
+    int slot;
+    if(!slotFor(cellsPerSide, slot)) return false;
+    if(regionCoord(cx) != regionX || regionCoord(cz) != regionZ) return false;
+
+    uint64_t entry = currentMapping()->index()[indexFor(cx, cz, slot)].load(std::memory_order_acquire);
+    if(entry == 0) return false;
+
+    offset = entryOffset(entry);
+    size = uint32_t(entrySize(entry));
+    return true;
+}
+
+bool RegionFile::read(int cx, int cz, int cellsPerSide, HeightGrid& out) const{
+    uint64_t offset;
+    uint32_t size;
+    if(!locate(cx, cz, cellsPerSide, offset, size)) return false;
+
+    // Decoded straight out of the mapping
+    std::shared_ptr<const Mapping> m = currentMapping();
+    if(offset + size > m->length){
+        m = mappingCovering(offset + size);
+        if(!m) return false;
+    }
+    return decodePayload(cx, cz, cellsPerSide, m->base + offset, size, out);
+}
+
+bool RegionFile::readRaw(uint64_t offset, uint32_t size, uint8_t* out) const{
+    std::shared_ptr<const Mapping> m = currentMapping();
+    if(offset + size > m->length){
+        m = mappingCovering(offset + size);
+        if(!m) return false;
+    }
+    std::memcpy(out, m->base + offset, size);
+    return true;
+}
+
+bool RegionFile::decodePayload(int cx, int cz, int cellsPerSide, const uint8_t* data, size_t size, HeightGrid& out){
+    // Validate before trusting anything from disk
+    PayloadHeader h;
+    if(size < sizeof(h)) return false;
+    std::memcpy(&h, data, sizeof(h));
+    if(h.chunkX != cx || h.chunkZ != cz || h.cellsPerSide != cellsPerSide || h.apron < 0 || h.apron > 1) return false;
+
+    HeightGrid grid;
+    grid.cellsPerSide = h.cellsPerSide;
+    grid.apron = h.apron;
+    const size_t count = size_t(grid.stride()) * size_t(grid.stride());
+
+    grid.heights.resize(count);
+    if(!HeightCodec::decode(data + sizeof(h), size - sizeof(h), grid.heights.data(), count)) return false;
+
+    out = std::move(grid);
+    return true;
+}
+
+bool RegionFile::encodePayload(int cx, int cz, const HeightGrid& grid, float precision, std::vector<uint8_t>& out){
+    int slot;
+    if(grid.empty() || !slotFor(grid.cellsPerSide, slot)) return false;
+
+    PayloadHeader h;
+    h.chunkX = cx;
+    h.chunkZ = cz;
+    h.cellsPerSide = grid.cellsPerSide;
+    h.apron = grid.apron;
+
+    out.resize(sizeof(h));
+    std::memcpy(out.data(), &h, sizeof(h));
+    return HeightCodec::encode(grid.heights.data(), grid.stride(), grid.stride(), precision, out);
+}
+
+bool RegionFile::write(int cx, int cz, const HeightGrid& grid, float precision, size_t* written){
+    int slot;
+    if(grid.empty() || !slotFor(grid.cellsPerSide, slot)) return false;
+    if(regionCoord(cx) != regionX || regionCoord(cz) != regionZ) return false;
+
+    std::vector<uint8_t> payload;
+    if(!encodePayload(cx, cz, grid, precision, payload)) return false;
+
+    if(written) *written = payload.size();
+    return append(indexFor(cx, cz, slot), payload.data(), payload.size());
+}
+
+bool RegionFile::reserve(size_t size, uint64_t& offset){
+    if(size > MAX_PAYLOAD) return false;
+
+    // Appends only claim their range under the lock; the writes themselves
+    // may overlap
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if(fileEnd > MAX_OFFSET) return false;
+    offset = fileEnd;
+    fileEnd = alignUp(offset + size);
+    return true;
+}
+
+bool RegionFile::writeRaw(uint64_t offset, const uint8_t* data, size_t size){
+    return file->writeAt(offset, data, size);
+}
+
+bool RegionFile::publish(int cx, int cz, int cellsPerSide, uint64_t offset, size_t size){
+    int slot;
+    if(!slotFor(cellsPerSide, slot)) return false;
+    if(regionCoord(cx) != regionX || regionCoord(cz) != regionZ) return false;
+    if(size > MAX_PAYLOAD || offset > MAX_OFFSET) return false;
+
+    // Only after the payload is in the file; readers that see the entry
+    // remap if their view is too short
+    currentMapping()->index()[indexFor(cx, cz, slot)].store(packEntry(offset, size), std::memory_order_release);
+    return true;
+}
+
+bool RegionFile::append(size_t index, const uint8_t* payload, size_t size){
+    uint64_t offset;
+    if(!reserve(size, offset)) return false;
+    if(!file->writeAt(offset, payload, size)) return false;
+
+    currentMapping()->index()[index].store(packEntry(offset, size), std::memory_order_release);
+    return true;
+}
+
+int RegionFile::descriptor() const{
+#ifdef _WIN32
+    return -1;
+#else
+    return file->fd;
+#endif
+}
+
+RegionFile::Usage RegionFile::usage() const{
+    Usage u;
+    u.fileBytes = file->size();
+    u.liveBytes = HEADER_BYTES;
+
+    std::shared_ptr<const Mapping> m = currentMapping();
+    for(size_t i = 0; i < INDEX_ENTRIES; ++i){
+        uint64_t entry = m->index()[i].load(std::memory_order_acquire);
+        if(entry == 0) continue;
+        u.liveBytes += entrySize(entry);
+        ++u.entries;
+    }
+    return u;
+}
+
+namespace {
+    bool readHeader(const std::string& path, RegionHeader& h){
+        std::ifstream in(path, std::ios::binary);
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&h), sizeof(h)));
+    }
+}
+
+bool RegionFile::inspect(const std::string& path, Usage& out){
+    RegionHeader h;
+    if(!readHeader(path, h)) return false;
+
+    std::shared_ptr<RegionFile> region = open(path, h.paramsHash, h.regionX, h.regionZ, false);
+    if(!region) return false;
+    out = region->usage();
+    return true;
+}
+
+bool RegionFile::compact(const std::string& path, Usage* before, Usage* after){
+    RegionHeader h;
+    if(!readHeader(path, h)) return false;
+
+    std::shared_ptr<RegionFile> src = open(path, h.paramsHash, h.regionX, h.regionZ, false);
+    if(!src) return false;
+
+    const std::string temp = path + ".compact";
+    std::error_code ec;
+    std::filesystem::remove(temp, ec);
+
+    std::shared_ptr<RegionFile> dst = open(temp, h.paramsHash, h.regionX, h.regionZ, true);
+    if(!dst) return false;
+
+    // Live payloads are copied as they are, in index order
+    std::shared_ptr<const Mapping> m = src->mappingCovering(src->file->size());
+    bool ok = m != nullptr;
+    for(size_t i = 0; ok && i < INDEX_ENTRIES; ++i){
+        uint64_t entry = m->index()[i].load(std::memory_order_acquire);
+        if(entry == 0) continue;
+        uint64_t offset = entryOffset(entry);
+        uint64_t size = entrySize(entry);
+        if(offset + size > m->length) continue;  // damaged entry, dropped
+        ok = dst->append(i, m->base + offset, size_t(size));
+    }
+
+    if(before) *before = src->usage();
+    if(after) *after = dst->usage();
+
+    // Both views must be closed before the rename (required on Windows)
+    m.reset();
+    src.reset();
+    dst.reset();
+
+    if(!ok){
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
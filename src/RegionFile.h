@@ -0,0 +1,96 @@
+#ifndef REGION_FILE_H
+#define REGION_FILE_H
+
+#include "TerrainGenerator.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One cache file for REGION_SIDE x REGION_SIDE chunks: a fixed header with
+// an index of (chunk, grid size) entries, followed by appended payloads of
+// HeightCodec-encoded heights. Readers go through a shared memory mapping and
+// take no lock; writers claim an appended range under a lock, write their
+// payload into it, then publish its index entry with a single atomic store.
+// Rewriting an entry leaves the old payload behind as dead space until the
+// file is compacted.
+class RegionFile{
+public:
+    static constexpr int REGION_SIDE = 32;
+    static constexpr int SLOTS_PER_CHUNK = 8;  // grid sizes 2^slot + 1
+
+    struct Usage{
+        uint64_t fileBytes = 0;
+        uint64_t liveBytes = 0;  // header plus payloads the index points to
+        uint32_t entries = 0;
+    };
+
+    ~RegionFile();
+
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    // nullptr if the file does not exist (and create is false), belongs to
+    // other parameters or cannot be mapped
+    static std::shared_ptr<RegionFile> open(const std::string& path, uint64_t paramsHash, int regionX, int regionZ, bool create);
+
+    // Region holding a chunk, and the chunk's coordinates inside it
+    static int regionCoord(int chunkCoord);
+    static int localCoord(int chunkCoord);
+
+    // Whether a grid of this size has an index slot
+    static bool slotFor(int cellsPerSide, int& slot);
+
+    // Lock-free; false on a miss. Chunk coordinates are absolute.
+    bool read(int cx, int cz, int cellsPerSide, HeightGrid& out) const;
+
+    // Encodes at `precision`, appends and publishes. *written receives the payload size.
+    bool write(int cx, int cz, const HeightGrid& grid, float precision, size_t* written = nullptr);
+
+    // The same steps split up for callers doing their own (asynchronous)
+    // file I/O: find a payload and copy it out, or reserve room for one,
+    // write it (writeRaw() or through descriptor()) and publish it once it
+    // is on disk.
+    bool locate(int cx, int cz, int cellsPerSide, uint64_t& offset, uint32_t& size) const;
+    bool readRaw(uint64_t offset, uint32_t size, uint8_t* out) const;
+    bool reserve(size_t size, uint64_t& offset);
+    bool writeRaw(uint64_t offset, const uint8_t* data, size_t size);
+    bool publish(int cx, int cz, int cellsPerSide, uint64_t offset, size_t size);
+
+    // POSIX file descriptor, -1 on Windows
+    int descriptor() const;
+
+    static bool encodePayload(int cx, int cz, const HeightGrid& grid, float precision, std::vector<uint8_t>& out);
+    static bool decodePayload(int cx, int cz, int cellsPerSide, const uint8_t* data, size_t size, HeightGrid& out);
+
+    Usage usage() const;
+
+    // Usage of a region file on disk, whatever parameters it belongs to
+    static bool inspect(const std::string& path, Usage& out);
+
+    // Rewrites the file with only the live payloads. Offline only: no other
+    // RegionFile may have the file open.
+    static bool compact(const std::string& path, Usage* before = nullptr, Usage* after = nullptr);
+
+private:
+    struct Platform;
+    struct Mapping;
+
+    RegionFile();
+
+    std::unique_ptr<Platform> file;
+    mutable std::shared_ptr<const Mapping> mapping;  // replaced when a reader needs a longer view
+    mutable std::mutex remapMutex;
+    std::mutex writeMutex;
+    uint64_t fileEnd = 0;                    // next append offset, under writeMutex
+    uint64_t paramsHash = 0;
+    int regionX = 0, regionZ = 0;
+
+    std::shared_ptr<const Mapping> currentMapping() const;
+    std::shared_ptr<const Mapping> mappingCovering(uint64_t end) const;
+    bool append(size_t index, const uint8_t* payload, size_t size);
+    static size_t indexFor(int cx, int cz, int slot);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "ResidencyTracker.h"
+#include <unordered_set>
+#include <utility>
+
+ResidencyTracker::ResidencyTracker(int loadRadius_, int unloadRadius_, std::vector<int> lodRadii_, int lodMargin_)
+    : loadRadius(loadRadius_), unloadRadius(std::max(unloadRadius_, loadRadius_)), lodRadii(std::move(lodRadii_)),
+      lodMargin(std::max(lodMargin_, 0))
+{
+}
+
+int ResidencyTracker::lodForRing(int r) const{
+    for (size_t i = 0; i < lodRadii.size(); ++i) {
+        if (r <= lodRadii[i]) return static_cast<int>(i);
+    }
+    return static_cast<int>(lodRadii.size());
+}
+
+int ResidencyTracker::lodForRing(int r, int current) const{
+    const int refine = lodForRing(r);
+    if (current < 0) return refine;
+    const int coarsen = lodForRing(std::max(r - lodMargin, 0));
+    return std::min(std::max(current, coarsen), refine);
+}
+
+void ResidencyTracker::moveTo(const ChunkKey& newCenter, Changes& out){
+    out.entered.clear();
+    out.lodChanged.clear();
+    out.unloaded.clear();
+
+    if (!centered) {
+        // Empty old window: everything in the load window is new
+        forEachInSquareNotIn(newCenter, loadRadius, newCenter, -1, [&](const ChunkKey& k) {
+            out.entered.push_back(k);
+        });
+        center = newCenter;
+        centered = true;
+        return;
+    }
+
+    if (newCenter == center) return;
+
+    const ChunkKey oldCenter = center;
+
+    forEachInSquareNotIn(newCenter, loadRadius, oldCenter, loadRadius, [&](const ChunkKey& k) {
+        out.entered.push_back(k);
+    });
+    forEachInSquareNotIn(oldCenter, unloadRadius, newCenter, unloadRadius, [&](const ChunkKey& k) {
+        out.unloaded.push_back(k);
+    });
+
+    // A chunk can only change LOD by crossing one of the refine or coarsen
+    // squares, so the strips between the old and new square of each radius
+    // cover all of them; a chunk may cross several, hence the dedup
+    std::unordered_set<ChunkKey, ChunkKeyHash> seen;
+    auto check = [&](const ChunkKey& k) {
+        const int ro = ring(oldCenter, k), rn = ring(newCenter, k);
+        if (rn > loadRadius || ro > loadRadius) return;
+        if (lodForRing(rn) == lodForRing(ro) &&
+            lodForRing(std::max(rn - lodMargin, 0)) == lodForRing(std::max(ro - lodMargin, 0))) return;
+        if (seen.insert(k).second) out.lodChanged.push_back(k);
+    };
+    auto visit = [&](int r) {
+        if (r >= loadRadius) return;
+        forEachInSquareNotIn(newCenter, r, oldCenter, r, check);
+        forEachInSquareNotIn(oldCenter, r, newCenter, r, check);
+    };
+    for (int r : lodRadii) {
+        visit(r);
+        if (lodMargin > 0) visit(r + lodMargin);
+    }
+
+    center = newCenter;
+}
@@ -0,0 +1,85 @@
+#ifndef RESIDENCY_TRACKER_H
+#define RESIDENCY_TRACKER_H
+
+#include "ChunkKey.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+// Square (Chebyshev) rings of chunks around the camera chunk: a load window,
+// a larger unload window and nested per-LOD squares. When the centre moves
+// only the strips that changed membership are visited, so the cost is
+// O(perimeter * shift) instead of O(window area).
+//
+// LOD squares have a hysteresis band: a chunk refines to LOD i inside ring
+// lodRadii[i] but only drops back to a coarser LOD past ring
+// lodRadii[i] + lodMargin, so hovering on a ring does not flip it.
+class ResidencyTracker {
+public:
+    struct Changes {
+        std::vector<ChunkKey> entered;     // now inside the load window
+        std::vector<ChunkKey> lodChanged;  // stayed inside, crossed a refine or coarsen ring
+        std::vector<ChunkKey> unloaded;    // left the unload window
+    };
+
+    // lodRadii[i] is the outermost ring that still wants LOD i; rings
+    // beyond the last entry want LOD lodRadii.size()
+    ResidencyTracker(int loadRadius, int unloadRadius, std::vector<int> lodRadii, int lodMargin = 0);
+
+    // Re-centres the windows; the first call enters the whole load window
+    void moveTo(const ChunkKey& newCenter, Changes& out);
+
+    bool hasCenter() const { return centered; }
+    const ChunkKey& getCenter() const { return center; }
+    int getLoadRadius() const { return loadRadius; }
+    int getUnloadRadius() const { return unloadRadius; }
+
+    static int ring(const ChunkKey& center, const ChunkKey& key) {
+        return std::max(std::abs(key.x - center.x), std::abs(key.z - center.z));
+    }
+
+    int lodForRing(int r) const;
+    int wantedLod(const ChunkKey& key) const { return lodForRing(ring(center, key)); }
+    int wantedLodFrom(const ChunkKey& from, const ChunkKey& key) const { return lodForRing(ring(from, key)); }
+
+    // LOD for a chunk currently at `current` (-1 for none): finer as soon as
+    // a refine ring is crossed, coarser only past the coarsen ring
+    int lodForRing(int r, int current) const;
+    int wantedLod(const ChunkKey& key, int current) const { return lodForRing(ring(center, key), current); }
+
+    bool inLoadWindow(const ChunkKey& key) const { return centered && ring(center, key) <= loadRadius; }
+    bool inUnloadWindow(const ChunkKey& key) const { return centered && ring(center, key) <= unloadRadius; }
+
+    // Calls fn(key) for every chunk within ring ra of a that is not within
+    // ring rb of b, visiting only those chunks (plus one check per row)
+    template<typename Fn>
+    static void forEachInSquareNotIn(const ChunkKey& a, int ra, const ChunkKey& b, int rb, Fn&& fn);
+
+private:
+    int loadRadius;
+    int unloadRadius;
+    std::vector<int> lodRadii;
+    int lodMargin;
+
+    ChunkKey center{0, 0};
+    bool centered = false;
+};
+
+template<typename Fn>
+void ResidencyTracker::forEachInSquareNotIn(const ChunkKey& a, int ra, const ChunkKey& b, int rb, Fn&& fn){
+    const int bx0 = b.x - rb, bx1 = b.x + rb;
+    const int bz0 = b.z - rb, bz1 = b.z + rb;
+
+    for (int z = a.z - ra; z <= a.z + ra; ++z) {
+        const int ax0 = a.x - ra, ax1 = a.x + ra;
+        if (z < bz0 || z > bz1) {
+            for (int x = ax0; x <= ax1; ++x) fn(ChunkKey{x, z});
+            continue;
+        }
+        // Row overlaps b: only the columns left and right of it
+        for (int x = ax0; x <= std::min(ax1, bx0 - 1); ++x) fn(ChunkKey{x, z});
+        for (int x = std::max(ax0, bx1 + 1); x <= ax1; ++x) fn(ChunkKey{x, z});
+    }
+}
+
+#endif
@@ -61,6 +61,14 @@ void Shader::setFloat(const std::string& name, float value) const{
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const{
+    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
+void Shader::setIVec2(const std::string& name, const glm::ivec2& value) const{
+    glUniform2iv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const{
     glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
 }
@@ -1,90 +1,114 @@
 #include "Terrain.h"
+#include "GridIndexBuffer.h"
+#include <algorithm>
+#include <cstdlib>
 #include <thread>
 #include <vector>
-#include <chrono>
 
-Terrain::Terrain(int chunksX_, int chunksZ_, int cellsPerSide_, float worldScale_, TerrainGenerator& generator_)
-    : chunksX(chunksX_), chunksZ(chunksZ_), cellsPerSide(cellsPerSide_), worldScale(worldScale_), generator(generator_)
+Terrain::Terrain(int chunksX_, int chunksZ_, int cellsPerSide_, float worldScale_, TerrainGenerator& generator_, ThreadPool& jobPool_,
+                 const glm::vec3& startPos, const LodChain& lods_)
+    : chunksX(chunksX_), chunksZ(chunksZ_), cellsPerSide(cellsPerSide_), worldScale(worldScale_), generator(generator_),
+      jobPool(jobPool_), lods(lods_), generateRadius(ringsForDistance(lods.viewDistance())),
+      cache(std::make_shared<TerrainCache>("cache/terrain")),
+      cacheIO(std::make_unique<CacheIO>(cache)),
+      coldChunks(coldBudgetBytes),
+      memoryBudget(lods.count(), cpuMeshBudgetBytes, gpuMeshBudgetBytes),
+      residency(generateRadius, std::max(ringsForDistance(UNLOAD_DISTANCE), generateRadius + UNLOAD_MARGIN_RINGS),
+                lodRings(), LOD_HYSTERESIS_RINGS),
+      grid(residency.getUnloadRadius())
 {
-    generateRadius = 16;
-    lastCamPos = glm::vec3(0.0f);
+    lastCamPos = startPos;
     firstFrame = true;
+    startTime = std::chrono::steady_clock::now();
     updateFrameCounter = 0;  // Initialize properly
 
-    generateInitialTerrain(glm::vec3(0));
+    // One shared index buffer per LOD, bound by every chunk mesh
+    for(int lod = 0; lod < lods.count(); ++lod){
+        GridIndexBuffer::get(lods.cells(lod));
+    }
+
+    generateInitialTerrain(startPos);
 }
 
 Terrain::~Terrain(){
-    // Wait for all pending futures to complete before destroying
-    for(auto& it : pendingFutures){
-        if(it.second.valid()){
-            it.second.wait();
-        }
-    }
-    
-    for(auto& it : chunks){
-        delete it.second;
-    }
-    chunks.clear();
+    // Pending jobs only write into their own JobResult, so they can be
+    // abandoned here; cancelling lets the pool drop the queued ones and the
+    // running ones return early instead of finishing for nobody
+    grid.forEach([](ChunkSlot& slot) {
+        if (slot.hasPending) slot.pending.cancel.cancel();
+        delete slot.chunk;
+        slot.chunk = nullptr;
+    });
 }
 
 void Terrain::generateInitialTerrain(const glm::vec3 cameraPos){
-    ChunkKey camKey = worldToChunk(cameraPos.x, cameraPos.z);
-    int cx0 = camKey.x;
-    int cz0 = camKey.z;
-
+    // Centre the windows (and the grid) on the camera first; every chunk in
+    // the load window starts out as needing a request at its wanted LOD
+    residency.moveTo(worldToChunk(cameraPos.x, cameraPos.z), residencyChanges);
+    applyResidencyChanges();
+
+    // The whole load window goes to the pool at once as cheap coarsest-LOD
+    // placeholders, nearest first. Finer LODs are requested the regular
+    // way once a placeholder is uploaded.
+    const int coarse = lods.count() - 1;
+    const ChunkKey camKey = residency.getCenter();
+    const glm::vec3 noHeading(0.0f);
     for (int dz = -generateRadius; dz <= generateRadius; ++dz) {
         for (int dx = -generateRadius; dx <= generateRadius; ++dx) {
-            int cx = dx + cx0;
-            int cz = dz + cz0;
-            ChunkKey key{cx, cz};
-
-            // FIXED: Lock generator for synchronous initial generation
-            MeshData data;
-            {
-                std::lock_guard<std::mutex> lock(generatorMutex);
-                data = generator.generateChunk(cx, cz, lodCellsForIndex(0), worldScale);
-            }
+            ChunkKey key{camKey.x + dx, camKey.z + dz};
+            requestChunkAsync(key.x, key.z, coarse, requestPriority(key.x, key.z, cameraPos, noHeading, false));
+            grid.find(key)->pending.placeholder = true;
+        }
+    }
 
-            TerrainChunk* chunk = new TerrainChunk(cx, cz, generator, cellsPerSide, worldScale);
-            chunks[key] = chunk;
-            chunk->buildLodFromData(data, 0);
+    // Block only until the chunks around the camera can be drawn
+    auto neighbourhoodReady = [&]() {
+        for (int dz = -FIRST_FRAME_RINGS; dz <= FIRST_FRAME_RINGS; ++dz) {
+            for (int dx = -FIRST_FRAME_RINGS; dx <= FIRST_FRAME_RINGS; ++dx) {
+                if (!lodReady(ChunkKey{camKey.x + dx, camKey.z + dz}, coarse)) return false;
+            }
+        }
+        return true;
+    };
+    while (!neighbourhoodReady()) {
+        finalizeReadyJobs();
+        uploadReadyMeshes(cameraPos, noHeading);
+        if (!neighbourhoodReady()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
         }
     }
 }
 
-void Terrain::draw(const Frustum& f, glm::vec3 cameraPos, bool wireframe)
+void Terrain::draw(const Shader& shader, const Frustum& f, bool wireframe)
 {
-    for (auto& it : chunks) {
-        TerrainChunk* c = it.second;
-        if (!c) continue;
+    if (!hasFrustum) {
+        std::chrono::duration<float> sinceStart = std::chrono::steady_clock::now() - startTime;
+        stats.timeToFirstFrame = sinceStart.count();
+    }
 
-        // Check if chunk has at least one LOD ready
-        if (!c->lodReady[0] && !c->lodReady[1] && !c->lodReady[2]) {
-            continue;  // Skip chunks with no LOD ready
-        }
+    lastFrustum = f;
+    hasFrustum = true;
+    ++drawFrame;
 
-        glm::vec3 center = getChunkCenterWorld(it.first.x, it.first.z);
-        float distance = glm::distance(cameraPos, center);
-        int lod = getLODForDistance(distance);
-
-        // Fallback to available LOD if requested one isn't ready
-        if (!c->lodReady[lod]) {
-            // Try LOD 0, then 1, then 2
-            if (c->lodReady[0]) lod = 0;
-            else if (c->lodReady[1]) lod = 1;
-            else if (c->lodReady[2]) lod = 2;
-            else continue;  // No LOD available
-        }
+    // Spatial order over the resident window, no hashing
+    grid.forEachInWindow(residency.getCenter(), residency.getUnloadRadius(), [&](ChunkSlot& slot) {
+        TerrainChunk* c = slot.chunk;
+        if (!c) return;
+
+        int lod = drawLodFor(slot);
+        if (lod < 0) return;  // No LOD available
+
+        // Used even when culled, so turning around does not evict it
+        c->lodMap[lod].lastUsedFrame = drawFrame;
 
         glm::vec3 minB = c->getMin(lod);
         glm::vec3 maxB = c->getMax(lod);
 
         if (!isInFrustum(f, minB, maxB))
-            continue;
+            return;
 
-        c->draw(lod, wireframe);
-    }
+        c->draw(shader, lod, wireframe);
+    });
 }
 
 ChunkKey Terrain::worldToChunk(float worldX, float worldZ) const{
@@ -102,36 +126,81 @@ void Terrain::regenerateAround(int centerChunkX, int centerChunkZ, int radius){
 
     for (int cz = minZ; cz <= maxZ; ++cz) {
         for (int cx = minX; cx <= maxX; ++cx) {
-            ChunkKey key{cx, cz};
-            auto it = chunks.find(key);
-            
-            if (it != chunks.end() && it->second) {
-                // FIXED: Lock generator access
-                std::lock_guard<std::mutex> lock(generatorMutex);
-                it->second->regenerate(generator, 0, 65);
+            TerrainChunk* chunk = getChunk(cx, cz);
+            if (chunk) {
+                trackLod(*chunk, 0, false);
+                chunk->regenerate(generator, 0, lods.cells(0));
+                trackLod(*chunk, 0, true);
             }
         }
     }
 }
 
-TerrainChunk* Terrain::getChunk(int cx, int cz){
-    ChunkKey key{cx, cz};
-    auto it = chunks.find(key);
-    
-    if(it == chunks.end()){
-        return nullptr;
+ChunkKey Terrain::residencyCenter(const glm::vec3& cameraPos) const{
+    ChunkKey key = worldToChunk(cameraPos.x, cameraPos.z);
+    if (!residency.hasCenter()) return key;
+
+    // Keep the current centre while the camera stays within the margin
+    // around its chunk, so hovering on a chunk edge moves nothing
+    const ChunkKey& center = residency.getCenter();
+    const float size = (cellsPerSide - 1) * worldScale;
+    const float margin = CENTER_HYSTERESIS * size;
+    const float x0 = center.x * size, z0 = center.z * size;
+    if (cameraPos.x >= x0 - margin && cameraPos.x <= x0 + size + margin &&
+        cameraPos.z >= z0 - margin && cameraPos.z <= z0 + size + margin) {
+        return center;
+    }
+    return key;
+}
+
+int Terrain::wantedLod(const ChunkKey& key) const{
+    const ChunkSlot* slot = grid.find(key);
+    return (slot && slot->lod >= 0) ? slot->lod : residency.wantedLod(key);
+}
+
+int Terrain::drawLodFor(const ChunkSlot& slot) const{
+    const TerrainChunk& chunk = *slot.chunk;
+    int lod = slot.lod >= 0 ? slot.lod : residency.wantedLod(slot.key);
+    if (chunk.lodReady[lod]) return lod;
+
+    // Fallback to the finest available LOD if the wanted one isn't ready
+    for (int l = 0; l < lods.count(); ++l) {
+        if (chunk.lodReady[l]) return l;
     }
-    
-    return it->second;
+    return -1;
 }
 
-int Terrain::getLODForDistance(float distance) {
-    if(distance < 150) return 0; 
-    if(distance < 300) return 1; 
-    return 2;                     
+TerrainChunk* Terrain::getChunk(int cx, int cz){
+    ChunkSlot* slot = grid.find(ChunkKey{cx, cz});
+    return slot ? slot->chunk : nullptr;
 }
 
-void Terrain::update(float dt, const glm::vec3& cameraPos){
+bool Terrain::lodReady(const ChunkKey& key, int lod) const{
+    const ChunkSlot* slot = grid.find(key);
+    return slot && slot->chunk && slot->chunk->lodReady[lod];
+}
+
+int Terrain::ringsForDistance(float distance) const{
+    return static_cast<int>(distance / ((cellsPerSide - 1) * worldScale));
+}
+
+void Terrain::update(float dt, const Camera& camera){
+    const glm::vec3 cameraPos = camera.getPosition();
+    const glm::vec3 forward = camera.getFront();
+
+    // Track the trajectory every frame, even when the update is skipped
+    prefetcher.observe(dt, camera);
+
+    // Polling is cheap now that uploads are deferred, so finished jobs are
+    // collected every frame and their meshes trickle in under the budget
+    finalizeReadyJobs();
+    uploadReadyMeshes(cameraPos, forward);
+    collectColdEncodes();
+    coldChunks.setBudget(coldBudgetBytes);
+    stats.cold = coldChunks.getStats();
+    stats.cacheIO = cacheIO->getStats();
+    stats.cacheBackend = cacheIO->backendName();
+
     if(firstFrame){
         firstFrame = false;
     }
@@ -145,65 +214,483 @@ void Terrain::update(float dt, const glm::vec3& cameraPos){
     lastCamPos = cameraPos;
     updateFrameCounter = 0;
 
-    // IMPORTANT: Finalize ready futures BEFORE checking for new requests
-    finalizeReadyFutures();
+    // Predict before cancelling, so prefetches along the path survive
+    stats.prefetchLookahead = prefetcher.lookahead(predictedUpdateDelay(dt));
+    predictedPath = prefetcher.predictPath(stats.prefetchLookahead, PREFETCH_PATH_STEPS);
+
+    // Drop work the camera no longer needs, then re-rank what is left;
+    // queued jobs were ranked for an older camera
+    cancelStaleJobs(cameraPos);
+    reprioritizePending(cameraPos, forward);
+
+    // Only the window strips that changed membership are visited
+    residency.moveTo(residencyCenter(cameraPos), residencyChanges);
+    applyResidencyChanges();
+    retryDeferredLods(std::chrono::steady_clock::now());
+    enforceMemoryBudget(residency.getCenter());
+
+    std::vector<RequestCandidate> candidates;
+    size_t kept = 0;
+    for (size_t i = 0; i < needsRequest.size(); ++i) {
+        const ChunkKey key = needsRequest[i];
+        ChunkSlot* slot = grid.find(key);
+        if (!slot || !slot->needsRequest) continue;
+
+        // Pending jobs are re-queued by cancelStaleJobs if they go away
+        // unused, queued uploads once they are uploaded
+        int lod = wantedLod(key);
+        bool done = slot->hasPending || slot->hasUpload || !residency.inLoadWindow(key) || lodReady(key, lod);
+        if (done) {
+            slot->needsRequest = false;
+            grid.releaseIfUnused(*slot);
+            continue;
+        }
 
-    ChunkKey camKey = worldToChunk(cameraPos.x, cameraPos.z);
-    int cx0 = camKey.x;
-    int cz0 = camKey.z;
+        candidates.push_back({key, lod, requestPriority(key.x, key.z, cameraPos, forward)});
+        needsRequest[kept++] = key;
+    }
+    needsRequest.resize(kept);
+
+    // Issue the most important requests first instead of in raster order
+    issueRequests(candidates, MAX_NEW_REQUESTS_PER_FRAME, false);
 
-    const int MAX_NEW_REQUESTS_PER_FRAME = 8;
-    int newRequestsThisFrame = 0;
+    prefetchAhead(cameraPos);
 
-    // Request chunks in a spiral pattern (better than nested loops)
-    for(int dz = -generateRadius; dz <= generateRadius; ++dz){
-        for(int dx = -generateRadius; dx <= generateRadius; ++dx){
-            if (newRequestsThisFrame >= MAX_NEW_REQUESTS_PER_FRAME) break;
+    // Nothing left to request, generate or upload: startup has refined
+    // every chunk to its final LOD
+    if (stats.timeToFullDetail == 0.0f && needsRequest.empty() && pendingKeys.empty() && uploadKeys.empty()) {
+        std::chrono::duration<float> sinceStart = std::chrono::steady_clock::now() - startTime;
+        stats.timeToFullDetail = sinceStart.count();
+    }
+}
 
-            int cx = dx + cx0;
-            int cz = dz + cz0;
-            ChunkKey key{cx, cz};
+void Terrain::applyResidencyChanges(){
+    const auto now = std::chrono::steady_clock::now();
+    auto withinChurnWindow = [&](std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration<float>(now - t).count() < CHURN_WINDOW;
+    };
+
+    // Unloads first: after a long recentre jump an entering key maps to
+    // the toroidal slot of a key that is leaving
+    for (const ChunkKey& key : residencyChanges.unloaded) {
+        ChunkSlot* slot = grid.find(key);
+        if (slot) unloadChunk(*slot);
+        recentUnloads[key] = now;
+    }
+    for (const ChunkKey& key : residencyChanges.entered) {
+        auto it = recentUnloads.find(key);
+        if (it != recentUnloads.end()) {
+            if (withinChurnWindow(it->second)) ++stats.quickReloads;
+            recentUnloads.erase(it);
+        }
+        selectLod(claimSlot(key), now);
+        markNeedsRequest(key);
+    }
+    for (const ChunkKey& key : residencyChanges.lodChanged) {
+        ChunkSlot& slot = claimSlot(key);
+        if (selectLod(slot, now)) markNeedsRequest(key);
+        else grid.releaseIfUnused(slot);
+    }
 
-            glm::vec3 chunkCenter = getChunkCenterWorld(cx, cz);
-            float distance = glm::distance(cameraPos, chunkCenter);
-            int lod = getLODForDistance(distance);
+    if (!residencyChanges.unloaded.empty()) {
+        for (auto it = recentUnloads.begin(); it != recentUnloads.end();) {
+            if (withinChurnWindow(it->second)) ++it;
+            else it = recentUnloads.erase(it);
+        }
+    }
+}
 
-            // Skip if already pending
-            if (pendingFutures.count(key) > 0) continue;
+bool Terrain::selectLod(ChunkSlot& slot, std::chrono::steady_clock::time_point now){
+    const bool wasDeferred = slot.lodDeferred;
+    slot.lodDeferred = false;
 
-            // Check if chunk exists and LOD is ready
-            auto it = chunks.find(key);
-            if (it != chunks.end()) {
-                TerrainChunk* c = it->second;
-                if (c && c->lodReady[lod]) continue;
-            }
+    int target = residency.wantedLod(slot.key, slot.lod);
+    if (target == slot.lod) return false;
+    if (slot.lod < 0) {
+        slot.lod = target;
+        slot.lodSince = now;
+        return true;
+    }
+
+    // Refining never waits; the coarser mesh is what the player would see
+    std::chrono::duration<float> held = now - slot.lodSince;
+    if (target > slot.lod && held.count() < MIN_LOD_RESIDENCY) {
+        slot.lodDeferred = true;
+        if (!wasDeferred) {
+            deferredLods.push_back(slot.key);
+            ++stats.lodDeferrals;
+        }
+        return false;
+    }
+
+    ++stats.lodSwitches;
+    if (target == slot.previousLod && held.count() < CHURN_WINDOW) ++stats.lodReversals;
+    slot.previousLod = slot.lod;
+    slot.lod = target;
+    slot.lodSince = now;
+    return true;
+}
+
+void Terrain::retryDeferredLods(std::chrono::steady_clock::time_point now){
+    size_t kept = 0;
+    for (size_t i = 0; i < deferredLods.size(); ++i) {
+        const ChunkKey key = deferredLods[i];
+        ChunkSlot* slot = grid.find(key);
+        if (!slot || !slot->lodDeferred) continue;
+
+        if (selectLod(*slot, now)) markNeedsRequest(key);
+        if (slot->lodDeferred) deferredLods[kept++] = key;
+    }
+    deferredLods.resize(kept);
+}
+
+ChunkSlot& Terrain::claimSlot(const ChunkKey& key){
+    ChunkSlot* slot = grid.acquire(key);
+    if (slot) return *slot;
+
+    // Its previous owner is outside the window but was never unloaded
+    ChunkSlot* owner = grid.occupant(key);
+    unloadChunk(*owner);
+    ++stats.slotEvictions;
+    return *grid.acquire(key);
+}
+
+void Terrain::markNeedsRequest(const ChunkKey& key){
+    ChunkSlot& slot = claimSlot(key);
+    if (slot.needsRequest) return;
+    slot.needsRequest = true;
+    needsRequest.push_back(key);
+}
+
+void Terrain::unloadChunk(ChunkSlot& slot){
+    // Leaving the grid window: the slot is about to be reused by a chunk
+    // on the opposite side, so nothing may stay behind
+    if (slot.hasPending) {
+        cancelJob(slot);
+        removePending(slot);
+    }
+    if (slot.hasUpload) {
+        removeUpload(slot);
+    }
+    if (slot.chunk) {
+        trackChunk(*slot.chunk, false);
+        stashCold(slot.key, *slot.chunk);
+    }
+    delete slot.chunk;
+    slot.chunk = nullptr;
+    slot.needsRequest = false;
+    grid.releaseIfUnused(slot);
+}
+
+void Terrain::stashCold(const ChunkKey& key, TerrainChunk& chunk){
+    if (coldBudgetBytes == 0) return;
+
+    // Heights from older parameters would be dropped on lookup anyway
+    LodMeshInfo* finest = chunk.finestLod();
+    uint64_t version = generator.getVersion();
+    if (!finest || finest->generatorVersion != version) return;
+
+    // The chunk is going away, so its mesh data moves into the job; the
+    // encoding runs behind all chunk work
+    ColdEncode encode;
+    encode.key = key;
+    encode.job = jobPool.submit([data = std::move(finest->data), version]() {
+        return ColdChunkCache::Entry::encode(HeightGrid::fromMesh(data), version);
+    }, COLD_ENCODE_PRIORITY);
+    coldEncodes.push_back(std::move(encode));
+}
+
+void Terrain::enforceMemoryBudget(const ChunkKey& camKey){
+    memoryBudget.cpuBudget = cpuMeshBudgetBytes;
+    memoryBudget.gpuBudget = gpuMeshBudgetBytes;
+    if (!memoryBudget.overBudget()) {
+        stats.meshMemory = memoryBudget.usage();
+        return;
+    }
+
+    // Totals are kept through uploads, evictions and unloads, so only an
+    // overrun pays for ranking every resident LOD
+    memoryBudget.beginScan();
+    grid.forEach([&](ChunkSlot& slot) {
+        TerrainChunk* c = slot.chunk;
+        if (!c) return;
+
+        int drawn = drawLodFor(slot);
+        int wanted = residency.inLoadWindow(slot.key) ? wantedLod(slot.key) : -1;
+        int distance = std::max(std::abs(slot.key.x - camKey.x), std::abs(slot.key.z - camKey.z));
+
+        for (const auto& it : c->lodMap) {
+            const LodMeshInfo& info = it.second;
+            MeshMemoryBudget::Resident r;
+            r.key = slot.key;
+            r.lod = it.first;
+            r.cpuBytes = info.cpuBytes();
+            r.gpuBytes = info.mesh ? info.gpuBytes : 0;
+            r.age = drawFrame - std::min(drawFrame, info.lastUsedFrame);
+            r.distance = distance;
+            r.pinned = it.first == drawn || it.first == wanted;
+            memoryBudget.add(r);
+        }
+    });
+
+    for (const MeshMemoryBudget::Eviction& e : memoryBudget.plan()) {
+        TerrainChunk* c = grid.find(e.key)->chunk;
+        trackLod(*c, e.lod, false);
+        if (e.cpuOnly) {
+            c->releaseCpuData(e.lod);
+            ++stats.releasedCpuCopies;
+        }
+        else {
+            c->evictLod(e.lod);
+            ++stats.evictedLods;
+        }
+        trackLod(*c, e.lod, true);
+    }
+    stats.meshMemory = memoryBudget.usage();
+}
+
+void Terrain::trackLod(const TerrainChunk& c, int lod, bool add){
+    const LodMeshInfo* info = c.getLodInfo(lod);
+    if (!info) return;
+
+    size_t cpu = info->cpuBytes();
+    size_t gpu = info->mesh ? info->gpuBytes : 0;
+    if (add) memoryBudget.track(lod, cpu, gpu);
+    else memoryBudget.untrack(lod, cpu, gpu);
+}
+
+void Terrain::trackChunk(const TerrainChunk& c, bool add){
+    for (const auto& it : c.lodMap) trackLod(c, it.first, add);
+}
+
+void Terrain::collectColdEncodes(){
+    for (size_t i = 0; i < coldEncodes.size();) {
+        if (!coldEncodes[i].job.poll()) {
+            ++i;
+            continue;
+        }
+        coldChunks.put(coldEncodes[i].key, coldEncodes[i].job.take());
+        coldEncodes[i] = std::move(coldEncodes.back());
+        coldEncodes.pop_back();
+    }
+}
+
+void Terrain::removePending(ChunkSlot& slot){
+    slot.hasPending = false;
+    slot.requestedLod = -1;
+    slot.pending = PendingChunk();
+
+    auto it = std::find(pendingKeys.begin(), pendingKeys.end(), slot.key);
+    if (it != pendingKeys.end()) {
+        *it = pendingKeys.back();
+        pendingKeys.pop_back();
+    }
+}
+
+void Terrain::removeUpload(ChunkSlot& slot){
+    slot.hasUpload = false;
+    slot.ready = ReadyChunk();
+
+    auto it = std::find(uploadKeys.begin(), uploadKeys.end(), slot.key);
+    if (it != uploadKeys.end()) {
+        *it = uploadKeys.back();
+        uploadKeys.pop_back();
+    }
+}
+
+void Terrain::issueRequests(std::vector<RequestCandidate>& candidates, int budget, bool prefetch){
+    size_t issue = std::min(candidates.size(), size_t(budget));
+    size_t sorted = useCache ? std::min(candidates.size(), issue + MAX_READ_AHEADS_PER_UPDATE) : issue;
+    std::partial_sort(candidates.begin(), candidates.begin() + sorted, candidates.end(),
+        [](const RequestCandidate& a, const RequestCandidate& b) { return a.priority > b.priority; });
 
-            // Request this LOD asynchronously
-            requestChunkAsync(cx, cz, lod);
-            requestedLod[key] = lod;
-            ++newRequestsThisFrame;
+    for(size_t i = 0; i < issue; ++i){
+        const RequestCandidate& c = candidates[i];
+        requestChunkAsync(c.key.x, c.key.z, c.lod, c.priority);
+
+        if (prefetch) {
+            grid.find(c.key)->pending.prefetch = true;
+            ++stats.prefetchRequests;
+        }
+    }
+
+    // The next ones in line get their cached heights into memory now, so
+    // their requests in a later update skip the disk
+    if (issue < sorted) {
+        uint64_t hash = TerrainCache::paramsHash(generator.getParams(), worldScale);
+        for (size_t i = issue; i < sorted; ++i) {
+            const RequestCandidate& c = candidates[i];
+            cacheIO->readAhead(hash, c.key.x, c.key.z, cacheLookupSizes(c.lod));
         }
-        if (newRequestsThisFrame >= MAX_NEW_REQUESTS_PER_FRAME) break;
+    }
+}
+
+void Terrain::prefetchAhead(const glm::vec3& cameraPos){
+    if (predictedPath.empty()) return;
+
+    ChunkKey camKey = residency.getCenter();
+    glm::vec3 travel = glm::normalize(prefetcher.getVelocity());
+    const int detailRadius = lods.count() > 1 ? ringsForDistance(lods.distance(lods.count() - 2)) : -1;
+
+    // For every predicted position, the chunks it would request that the
+    // current position does not: the strip of new chunks entering its load
+    // square and finer LODs close to the path. Earlier points rank higher.
+    std::unordered_map<ChunkKey, RequestCandidate, ChunkKeyHash> wanted;
+    for (size_t k = 0; k < predictedPath.size(); ++k) {
+        const glm::vec3& p = predictedPath[k];
+        ChunkKey pk = worldToChunk(p.x, p.z);
+        float timeWeight = PREFETCH_WEIGHT / float(k + 1);
+
+        auto consider = [&](const ChunkKey& key) {
+            // Results must land inside the grid window
+            if (!residency.inUnloadWindow(key)) return;
+
+            const ChunkSlot* slot = grid.find(key);
+            if (slot && (slot->hasPending || slot->hasUpload)) return;
+
+            int lod = residency.wantedLodFrom(pk, key);
+            if (residency.inLoadWindow(key) && lod >= wantedLod(key)) {
+                return;  // the regular requests already cover this
+            }
+
+            if (lodReady(key, lod)) return;
+
+            float priority = requestPriority(key.x, key.z, glm::vec3(p.x, cameraPos.y, p.z), travel, false) * timeWeight;
+            auto w = wanted.find(key);
+            if (w == wanted.end()) {
+                wanted.emplace(key, RequestCandidate{key, lod, priority});
+            }
+            else {
+                w->second.lod = std::min(w->second.lod, lod);
+                w->second.priority = std::max(w->second.priority, priority);
+            }
+        };
+
+        ResidencyTracker::forEachInSquareNotIn(pk, generateRadius, camKey, generateRadius, consider);
+        ResidencyTracker::forEachInSquareNotIn(pk, detailRadius, pk, -1, consider);
+    }
+
+    std::vector<RequestCandidate> candidates;
+    candidates.reserve(wanted.size());
+    for (auto& it : wanted) {
+        candidates.push_back(it.second);
+    }
+    issueRequests(candidates, MAX_PREFETCH_REQUESTS_PER_FRAME, true);
+}
+
+float Terrain::predictedUpdateDelay(float dt) const{
+    // update() runs every UPDATE_INTERVAL frames or after MIN_MOVE_DISTANCE
+    // of travel, whichever comes first
+    float delay = UPDATE_INTERVAL * dt;
+    float speed = prefetcher.getSpeed();
+    if (speed > 0.0f) delay = std::min(delay, MIN_MOVE_DISTANCE / speed);
+    return delay;
+}
+
+float Terrain::requestPriority(int cx, int cz, const glm::vec3& cameraPos, const glm::vec3& forward, bool useFrustum){
+    float chunkSize = (cellsPerSide - 1) * worldScale;
+    glm::vec3 center = getChunkCenterWorld(cx, cz);
+
+    // Projected size falls off with distance; clamp so the chunk under the
+    // camera does not dominate everything else
+    glm::vec2 toChunk(center.x - cameraPos.x, center.z - cameraPos.z);
+    float distance = std::max(glm::length(toChunk), chunkSize * 0.5f);
+    float importance = chunkSize / distance;
+
+    if (useFrustum && hasFrustum) {
+        TerrainGenerator::SnapshotPtr gen = generator.snapshot();
+        glm::vec3 minB(cx * chunkSize, gen->heightMin(), cz * chunkSize);
+        glm::vec3 maxB = minB + glm::vec3(chunkSize, gen->heightRange(), chunkSize);
+        if (!isInFrustum(lastFrustum, minB, maxB)) importance *= OUT_OF_VIEW_WEIGHT;
+    }
+
+    // Favour chunks ahead of the camera, also among those not yet in view
+    glm::vec2 heading(forward.x, forward.z);
+    float headingLen = glm::length(heading);
+    if (headingLen > 1e-4f && glm::length(toChunk) > 1e-4f) {
+        float facing = glm::dot(heading / headingLen, glm::normalize(toChunk));
+        importance *= 1.0f - HEADING_WEIGHT * 0.5f * (1.0f - facing);
     }
 
-    unloadChunks(cameraPos);
+    return importance;
 }
 
-void Terrain::unloadChunks(const glm::vec3 cameraPos){
-    for(auto it = chunks.begin(); it != chunks.end();){
-        glm::vec3 center = getChunkCenterWorld(it->first.x, it->first.z);
-        float distance = glm::distance(cameraPos, center);
+void Terrain::cancelStaleJobs(const glm::vec3& cameraPos){
+    for (size_t i = 0; i < pendingKeys.size();) {
+        const ChunkKey key = pendingKeys[i];
+        ChunkSlot& slot = *grid.find(key);
+        PendingChunk& pending = slot.pending;
+
+        bool stale = !jobWanted(key, pending);
 
-        if(distance > UNLOAD_DISTANCE){
-            delete it->second;
-            it = chunks.erase(it);
+        // Prefetches are judged against the predicted path as well, and
+        // become regular requests once the camera itself wants their LOD
+        if (pending.prefetch) {
+            for (const glm::vec3& p : predictedPath) {
+                if (!stale) break;
+                stale = !jobWantedAt(key, pending, glm::vec3(p.x, cameraPos.y, p.z));
+            }
+
+            if (!stale && wantedLod(key) == pending.firstLod && jobWanted(key, pending)) {
+                pending.prefetch = false;
+                ++stats.prefetchPromoted;
+            }
         }
-        else{
-            ++it;
+
+        if (stale) {
+            cancelJob(slot);
+            removePending(slot);  // swaps the last key into i
+            if (residency.inLoadWindow(key)) markNeedsRequest(key);
+            grid.releaseIfUnused(slot);
+        }
+        else {
+            ++i;
         }
     }
 }
 
+bool Terrain::jobCovers(const PendingChunk& pending, int lod){
+    // Startup placeholders stand in for whatever LOD is wanted; a pyramid
+    // job also covers the coarser LODs
+    return pending.placeholder || (lod >= pending.firstLod && lod < pending.firstLod + pending.lodCount);
+}
+
+bool Terrain::jobWanted(const ChunkKey& key, const PendingChunk& pending) const{
+    return residency.inLoadWindow(key) && jobCovers(pending, wantedLod(key));
+}
+
+bool Terrain::jobWantedAt(const ChunkKey& key, const PendingChunk& pending, const glm::vec3& position) const{
+    ChunkKey center = worldToChunk(position.x, position.z);
+    if (ResidencyTracker::ring(center, key) > generateRadius) {
+        return false;
+    }
+    return jobCovers(pending, residency.wantedLodFrom(center, key));
+}
+
+void Terrain::cancelJob(ChunkSlot& slot){
+    // Queued jobs are dropped by the pool, running ones stop at their next
+    // check; either way the result is never polled again
+    PendingChunk& pending = slot.pending;
+    pending.cancel.cancel();
+    ++stats.cancelledJobs;
+    stats.cancelledSamples += pending.noiseSamples;
+
+    // The job may never have decoded them, and the tier is their only copy
+    if (pending.cold) {
+        coldChunks.put(slot.key, *pending.cold);
+        pending.cold.reset();
+    }
+}
+
+void Terrain::reprioritizePending(const glm::vec3& cameraPos, const glm::vec3& forward){
+    for (const ChunkKey& key : pendingKeys) {
+        PendingChunk& pending = grid.find(key)->pending;
+        float priority = requestPriority(key.x, key.z, cameraPos, forward);
+        if (pending.prefetch) priority *= PREFETCH_WEIGHT;
+        pending.job.setPriority(priority);
+    }
+}
+
 glm::vec3 Terrain::getChunkCenterWorld(int cx, int cz){
     float chunkSize = (cellsPerSide - 1) * worldScale;
     float ox = cx * chunkSize;
@@ -215,68 +702,308 @@ glm::vec3 Terrain::getChunkCenterWorld(int cx, int cz){
     return glm::vec3(ox, 0.0f, oz);
 }
 
-void Terrain::requestChunkAsync(int cx, int cz, int lod){
+void Terrain::requestChunkAsync(int cx, int cz, int lod, float priority){
     ChunkKey key{cx, cz};
 
-    if (pendingFutures.count(key) > 0) return;
-
-    // CRITICAL FIX: Capture generator by reference, protect with mutex
-    pendingFutures[key] = std::async(std::launch::async, 
-        [this, cx, cz, lod]() -> MeshData {
-            int cells = lodCellsForIndex(lod);
-            
-            // Lock the generator while generating mesh data
-            std::lock_guard<std::mutex> lock(generatorMutex);
-            MeshData data = this->generator.generateChunk(cx, cz, cells, this->worldScale);
-            
-            return data;
-        });
-}
-
-int Terrain::lodCellsForIndex(int index){
-    switch(index){
-        case 0: return 65;
-        case 1: return 33;
-        case 2: return 17;
-        default: return 17;  // Default to lowest LOD
-    }
-}
-
-void Terrain::finalizeReadyFutures(){
-    using namespace std::chrono_literals;
-    std::vector<ChunkKey> finishedKeys;
-
-    for(auto it = pendingFutures.begin(); it != pendingFutures.end(); ++it){
-        ChunkKey key = it->first;
-        auto &fut = it->second;
-
-        // Check if future is valid and ready
-        if(fut.valid() && fut.wait_for(0ms) == std::future_status::ready){
-            MeshData data = fut.get();
-            int lod = requestedLod[key];
-
-            // Get or create chunk
-            TerrainChunk* chunk = nullptr;
-            auto chIt = chunks.find(key);
-            if (chIt != chunks.end()){
-                chunk = chIt->second;
-            } else {
-                // Create empty chunk (no initial generation)
-                chunk = new TerrainChunk(key.x, key.z);
-                chunk->baseCellsPerSide = cellsPerSide;
-                chunk->worldScale = worldScale;
-                chunks[key] = chunk;
-            }
+    ChunkSlot& slot = claimSlot(key);
+    if (slot.hasPending || slot.hasUpload) return;
+
+    // Capture by value: the job must not touch Terrain, which may be gone
+    // by the time a worker picks it up. The snapshot is immutable, so no
+    // lock is needed and jobs run fully in parallel.
+    int cells = lods.cells(lod);
+    float scale = worldScale;
+    TerrainGenerator::SnapshotPtr gen = generator.snapshot();
+
+    PendingChunk pending;
+    pending.firstLod = lod;
+    pending.generatorVersion = gen->getVersion();
+    pending.paramsHash = TerrainCache::paramsHash(gen->getParams(), worldScale);
+    pending.submitTime = std::chrono::steady_clock::now();
+
+    // A finer LOD is already resident: decimate its heights instead of
+    // evaluating the noise again (only the thin apron ring for the normals)
+    HeightGrid finer = slot.chunk ? slot.chunk->finerHeights(lod) : HeightGrid();
+
+    CancelToken token = pending.cancel;
+
+    if (!finer.empty()) {
+        pending.job = jobPool.submit([gen, finer, cx, cz, cells, scale, token]() -> ChunkJobResult {
+            ChunkJobResult out;
+            HeightGrid grid = gen->completeApron(cx, cz, finer.decimated(cells), scale);
+            if (token.cancelled()) return out;
+            out.lods.push_back(gen->buildMesh(cx, cz, grid, scale));
+            return out;
+        }, priority, token);
+        pending.lodCount = 1;
+        ++stats.derivedLods;
+        pending.noiseSamples = apronRingSamples(cells);
+    }
+    else {
+        // One noise pass at this LOD also yields every coarser one, so
+        // later LOD downgrades need no job at all
+        std::vector<int> chain;
+        int lastLod = buildLodPyramid ? lods.count() - 1 : lod;
+        for (int l = lod; l <= lastLod; ++l) {
+            chain.push_back(lods.cells(l));
+            if (l > lod) pending.noiseSamples += apronRingSamples(chain.back());
+        }
+        pending.noiseSamples += uint64_t(cells + 2) * uint64_t(cells + 2);
+        pending.lodCount = static_cast<int>(chain.size());
+
+        // Unloaded not long ago: its heights are still in RAM, so only the
+        // apron ring needs the noise
+        ColdChunkCache::Entry taken = coldChunks.take(key, gen->getVersion(), cells);
+
+        auto generate = [gen, chain, cx, cz, scale, token]() -> ChunkJobResult {
+            ChunkJobResult out;
+            HeightGrid grid = gen->generateHeights(cx, cz, chain.front(), scale, token.flag());
+            if (grid.empty()) return out;
+            out.lods = gen->buildLodChain(cx, cz, grid, chain, scale, token.flag());
+            out.generated = std::move(grid);
+            return out;
+        };
+
+        if (!taken.empty()) {
+            auto cold = std::make_shared<const ColdChunkCache::Entry>(std::move(taken));
+            pending.cold = cold;
+            pending.job = jobPool.submit([gen, cold, chain, cx, cz, scale, token]() -> ChunkJobResult {
+                ChunkJobResult out;
+                HeightGrid grid = gen->completeApron(cx, cz, cold->decode().decimated(chain.front()), scale);
+                if (grid.empty() || token.cancelled()) return out;
+                out.lods = gen->buildLodChain(cx, cz, grid, chain, scale, token.flag());
+                return out;
+            }, priority, token);
+            ++stats.coldHits;
+            pending.noiseSamples -= uint64_t(cells + 2) * uint64_t(cells + 2) - apronRingSamples(cells);
+        }
+        else if (!useCache) {
+            pending.job = jobPool.submit(generate, priority, token);
+        }
+        else {
+            // The handle exists before its job: the cache I/O thread looks
+            // the heights up, then queues the mesh job on a hit or the
+            // noise job on a miss, so no worker waits on the disk
+            auto state = std::make_shared<JobResult<ChunkJobResult>>();
+            state->priority.store(priority, std::memory_order_relaxed);
+            pending.job = JobHandle<ChunkJobResult>(state);
+
+            ThreadPool* pool = &jobPool;
+            cacheIO->read(pending.paramsHash, cx, cz, cacheLookupSizes(lod),
+                [pool, state, generate, gen, chain, cx, cz, scale, token](HeightGrid cached) {
+                if (token.cancelled()) return;
+                if (cached.empty()) {
+                    pool->submitTo(state, generate, token);
+                    return;
+                }
+
+                pool->submitTo(state, [gen, cached, chain, cx, cz, scale, token]() -> ChunkJobResult {
+                    ChunkJobResult out;
+                    const int cells = chain.front();
+
+                    // Decimating drops the apron, which costs one ring of samples
+                    HeightGrid grid = (cached.cellsPerSide == cells) ? cached
+                        : gen->completeApron(cx, cz, cached.decimated(cells), scale);
+                    out.samplesSaved = uint64_t(cells + 2) * uint64_t(cells + 2);
+                    if (cached.cellsPerSide != cells) out.samplesSaved -= apronRingSamples(cells);
+
+                    out.lods = gen->buildLodChain(cx, cz, grid, chain, scale, token.flag());
+                    return out;
+                }, token);
+            });
+        }
+    }
 
-            // Build this specific LOD
-            chunk->buildLodFromData(data, lod);
-            finishedKeys.push_back(key);
+    stats.noiseSamples += pending.noiseSamples;
+    slot.pending = std::move(pending);
+    slot.hasPending = true;
+    slot.requestedLod = lod;
+    pendingKeys.push_back(key);
+}
+
+uint64_t Terrain::apronRingSamples(int cells){
+    return 4 * uint64_t(cells + 1);
+}
+
+std::vector<int> Terrain::lodRings() const{
+    // Rings beyond the last entry want the coarsest LOD
+    std::vector<int> rings;
+    for (int lod = 0; lod + 1 < lods.count(); ++lod) {
+        rings.push_back(ringsForDistance(lods.distance(lod)));
+    }
+    return rings;
+}
+
+void Terrain::finalizeReadyJobs(){
+    for (size_t i = 0; i < pendingKeys.size();) {
+        const ChunkKey key = pendingKeys[i];
+        ChunkSlot& slot = *grid.find(key);
+        PendingChunk& pending = slot.pending;
+
+        // Poll without blocking; workers flag the result when done
+        if (!pending.job.poll()) {
+            ++i;
+            continue;
+        }
+
+        ChunkJobResult result = pending.job.take();
+
+        // Fresh heights are valid for the snapshot they came from, stale or not
+        if (!result.generated.empty()) {
+            writeBack(key, pending.paramsHash, std::move(result.generated));
+        }
+        if (result.samplesSaved > 0) {
+            stats.noiseSamples -= result.samplesSaved;
+            stats.cacheSamplesSaved += result.samplesSaved;
+            ++stats.cacheHits;
+        }
+
+        std::vector<MeshData> lods = std::move(result.lods);
+        bool stale = pending.generatorVersion != generator.getVersion();
+
+        if (!stale && pending.prefetch) {
+            ++stats.prefetchCompleted;
+        }
+
+        ReadyChunk ready;
+        ready.firstLod = pending.firstLod;
+        ready.generatorVersion = pending.generatorVersion;
+        ready.prefetch = pending.prefetch;
+        ready.submitTime = pending.submitTime;
+
+        // Swaps the last pending key into i
+        removePending(slot);
+
+        // Parameters changed while the job was running: drop the result,
+        // the chunk gets requested again from the current snapshot
+        if (stale) {
+            if (residency.inLoadWindow(key)) markNeedsRequest(key);
+            grid.releaseIfUnused(slot);
+            continue;
         }
+
+        // No GL work here; uploadReadyMeshes spreads it over frames
+        ready.lods = std::move(lods);
+        slot.ready = std::move(ready);
+        slot.hasUpload = true;
+        uploadKeys.push_back(key);
+    }
+}
+
+void Terrain::writeBack(const ChunkKey& key, uint64_t paramsHash, HeightGrid grid){
+    // Encoded and written on the cache I/O thread, behind its reads
+    cacheIO->write(paramsHash, key.x, key.z, std::move(grid));
+}
+
+std::vector<int> Terrain::cacheLookupSizes(int lod){
+    // Heights for this LOD, or for a finer one to decimate, may already be
+    // on disk; finest sizes are tried last
+    std::vector<int> sizes;
+    for (int l = lod; l >= 0; --l) sizes.push_back(lods.cells(l));
+    return sizes;
+}
+
+void Terrain::uploadReadyMeshes(const glm::vec3& cameraPos, const glm::vec3& forward){
+    using Clock = std::chrono::steady_clock;
+
+    stats.uploadBytes = 0;
+    stats.uploadMicros = 0.0f;
+    if (uploadKeys.empty()) {
+        stats.uploadQueued = 0;
+        return;
     }
 
-    // Cleanup finished futures
-    for (auto &k : finishedKeys) {
-        pendingFutures.erase(k);
-        requestedLod.erase(k);
+    // Same importance as requests: visible, large and ahead of the camera first
+    std::vector<std::pair<float, ChunkKey>> order;
+    order.reserve(uploadKeys.size());
+    for (const ChunkKey& key : uploadKeys) {
+        order.emplace_back(requestPriority(key.x, key.z, cameraPos, forward), key);
+    }
+    std::sort(order.begin(), order.end(),
+        [](const std::pair<float, ChunkKey>& a, const std::pair<float, ChunkKey>& b) { return a.first > b.first; });
+
+    size_t bytes = 0;
+    float micros = 0.0f;
+    int uploaded = 0;
+    bool budgetLeft = true;
+
+    for (size_t o = 0; o < order.size() && budgetLeft; ++o) {
+        const ChunkKey key = order[o].second;
+        ChunkSlot& slot = *grid.find(key);
+        ReadyChunk& ready = slot.ready;
+
+        if (ready.generatorVersion != generator.getVersion()) {
+            removeUpload(slot);
+            if (residency.inLoadWindow(key)) markNeedsRequest(key);
+            grid.releaseIfUnused(slot);
+            continue;
+        }
+
+        if (!slot.chunk) {
+            // Create empty chunk (no initial generation)
+            slot.chunk = new TerrainChunk(key.x, key.z, lods.count());
+            slot.chunk->baseCellsPerSide = cellsPerSide;
+            slot.chunk->worldScale = worldScale;
+        }
+        TerrainChunk* chunk = slot.chunk;
+
+        // Build the requested LOD plus any coarser ones the job derived,
+        // keeping coarse LODs that are already uploaded
+        for (; ready.next < ready.lods.size(); ++ready.next) {
+            int lod = ready.firstLod + static_cast<int>(ready.next);
+            if (lod >= lods.count()) {
+                ready.next = ready.lods.size();
+                break;
+            }
+            if (ready.next > 0 && chunk->lodReady[lod]) continue;
+
+            // Past the first mesh, stop before a mesh that would overrun
+            // either budget, judging its time by the measured cost so far
+            MeshData& data = ready.lods[ready.next];
+            size_t size = data.verticesCount() * sizeof(TerrainVertex);
+            float predicted = stats.uploadMicrosPerKiB * float(size) / 1024.0f;
+            if (uploaded > 0 && (bytes + size > uploadBudgetBytes || micros + predicted > uploadBudgetMicros)) {
+                budgetLeft = false;
+                break;
+            }
+
+            Clock::time_point start = Clock::now();
+            trackLod(*chunk, lod, false);
+            chunk->buildLodFromData(data, lod, ready.generatorVersion);
+            chunk->lodMap[lod].lastUsedFrame = drawFrame;
+            trackLod(*chunk, lod, true);
+            std::chrono::duration<float, std::micro> took = Clock::now() - start;
+
+            float perKiB = took.count() * 1024.0f / float(std::max<size_t>(size, 1));
+            stats.uploadMicrosPerKiB = stats.uploadMicrosPerKiB > 0.0f
+                ? stats.uploadMicrosPerKiB + 0.1f * (perKiB - stats.uploadMicrosPerKiB)
+                : perKiB;
+
+            bytes += size;
+            micros += took.count();
+            ++uploaded;
+            ++stats.uploadedMeshes;
+
+            // Prefetches wait behind visible work on purpose, only regular
+            // requests say how long the camera would wait for a chunk
+            if (ready.next == 0 && !ready.prefetch) {
+                std::chrono::duration<float> latency = Clock::now() - ready.submitTime;
+                prefetcher.recordLatency(latency.count());
+                stats.jobLatency = prefetcher.getLatency();
+            }
+        }
+        if (ready.next < ready.lods.size()) continue;
+
+        removeUpload(slot);
+
+        // The wanted LOD may have moved while the job ran
+        if (residency.inLoadWindow(key) && !chunk->lodReady[wantedLod(key)]) {
+            markNeedsRequest(key);
+        }
     }
-}
\ No newline at end of file
+
+    stats.uploadQueued = uploadKeys.size();
+    stats.uploadBytes = bytes;
+    stats.uploadMicros = micros;
+    stats.uploadMicrosPeak = std::max(stats.uploadMicrosPeak, micros);
+}
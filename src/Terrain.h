@@ -3,70 +3,254 @@
 
 #include "TerrainChunk.h"
 #include "Camera.h"
+#include "ChunkGrid.h"
+#include "ChunkKey.h"
+#include "ChunkPrefetcher.h"
+#include "ColdChunkCache.h"
+#include "LodChain.h"
+#include "MeshMemoryBudget.h"
+#include "ResidencyTracker.h"
+#include "CacheIO.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <memory>
 #include <unordered_map>
-#include <future>
-#include <mutex>
+#include <vector>
 
-struct ChunkKey {
-    int x, z;
-
-    bool operator==(const ChunkKey& other) const {
-        return x == other.x && z == other.z;
-    }
-};
-
-struct ChunkKeyHash {
-    std::size_t operator()(const ChunkKey& k) const {
-        // Fixed: proper 64-bit hash mixing
-        std::size_t h1 = std::hash<int>{}(k.x);
-        std::size_t h2 = std::hash<int>{}(k.z);
-        return h1 ^ (h2 << 1);
-    }
+struct TerrainStats {
+    uint64_t noiseSamples = 0;      // height samples sent to the noise backend
+    uint64_t derivedLods = 0;       // LODs decimated from a resident finer LOD
+    uint64_t cancelledJobs = 0;     // requests cancelled before their result was used
+    uint64_t cancelledSamples = 0;  // noise samples those jobs would have evaluated at most
+    uint64_t prefetchRequests = 0;  // requests issued for the predicted camera path
+    uint64_t prefetchPromoted = 0;  // prefetches the camera came to need while still pending
+    uint64_t prefetchCompleted = 0; // prefetches finalized before the camera needed them
+    float jobLatency = 0.0f;        // smoothed seconds from request to uploaded chunk
+    float prefetchLookahead = 0.0f; // seconds of predicted path used last update
+    uint64_t uploadedMeshes = 0;    // LOD meshes handed to the GPU
+    size_t uploadQueued = 0;        // finished chunks waiting for their upload
+    size_t uploadBytes = 0;         // vertex bytes uploaded last frame
+    float uploadMicros = 0.0f;      // measured upload time last frame
+    float uploadMicrosPeak = 0.0f;  // worst frame so far
+    float uploadMicrosPerKiB = 0.0f; // smoothed cost used to predict the next upload
+    float timeToFirstFrame = 0.0f;  // seconds from construction to the first draw
+    float timeToFullDetail = 0.0f;  // seconds until every chunk had its wanted LOD, 0 until then
+    uint64_t cacheHits = 0;         // chunk jobs served from the height cache
+    uint64_t cacheSamplesSaved = 0; // noise samples those jobs skipped
+    MeshMemoryBudget::Usage meshMemory; // resident CPU copies and GPU buffers per LOD
+    uint64_t evictedLods = 0;       // LOD meshes dropped for the GPU budget
+    uint64_t releasedCpuCopies = 0; // CPU copies dropped for the CPU budget
+    uint64_t lodSwitches = 0;       // selected LOD changes of resident chunks
+    uint64_t lodReversals = 0;      // switches back to the previous LOD within the churn window
+    uint64_t lodDeferrals = 0;      // coarsenings held back by the minimum residency time
+    uint64_t quickReloads = 0;      // chunks re-entering the load window within the churn window of unloading
+    uint64_t slotEvictions = 0;     // grid slots taken from a key that had not been unloaded yet
+    uint64_t coldHits = 0;          // chunk jobs re-meshed from the cold tier
+    ColdChunkCache::Stats cold;     // recently unloaded chunks kept compressed in RAM
+    CacheIO::Stats cacheIO;         // file-level counters of the async cache I/O
+    const char* cacheBackend = "";  // io_uring or threads
 };
 
 class Terrain{
 public:
-    Terrain(int chunksX, int chunksZ, int cellsPerSide, float worldScale, TerrainGenerator& generator);
+    Terrain(int chunksX, int chunksZ, int cellsPerSide, float worldScale, TerrainGenerator& generator, ThreadPool& jobPool,
+            const glm::vec3& startPos, const LodChain& lods = LodChain());
     ~Terrain();
 
-    void draw(const Frustum& f, glm::vec3 cameraPos, bool wireframe);
+    void draw(const Shader& shader, const Frustum& f, bool wireframe);
     ChunkKey worldToChunk(float worldX, float worldZ) const;
     void regenerateAround(int centerChunkX, int centerChunkZ, int radius);
-    void update(float dt, const glm::vec3& cameraPos);
+    void update(float dt, const Camera& camera);
     void generateInitialTerrain(const glm::vec3 cameraPos);
 
     TerrainChunk* getChunk(int cx, int cz);
+    const TerrainStats& getStats() const { return stats; }
+
+    // Generate every coarser LOD from the same noise pass as the requested one
+    bool buildLodPyramid = true;
+
+    // Look up generated heights on disk before evaluating the noise, and
+    // write freshly generated ones back in the background. Lookups run on
+    // the cache I/O thread and only then queue the mesh or noise job.
+    bool useCache = true;
+
+    // Resident mesh memory: CPU copies of uploaded meshes (MeshData) and GPU
+    // vertex buffers. Over budget, the least recently drawn and farthest
+    // LODs go first; the LOD a chunk draws or wants is never evicted.
+    size_t cpuMeshBudgetBytes = 8 * 1024 * 1024;
+    size_t gpuMeshBudgetBytes = 16 * 1024 * 1024;
+
+    // Compressed heights of unloaded chunks kept in RAM, least recently
+    // unloaded dropped first; 0 disables the cold tier
+    size_t coldBudgetBytes = 32 * 1024 * 1024;
+
+    // Per-frame GPU upload budget; the most important mesh is always
+    // uploaded, further ones only while both limits hold
+    size_t uploadBudgetBytes = 256 * 1024;
+    float uploadBudgetMicros = 1000.0f;
 
 private:
     int chunksX, chunksZ;
     int cellsPerSide;
     float worldScale;
     TerrainGenerator& generator;
-    int generateRadius;
+    ThreadPool& jobPool;
+    LodChain lods;
+    int generateRadius;          // rings out to the chain's view distance
     glm::vec3 lastCamPos;
 
     int updateFrameCounter = 0;  // Fixed: initialize to 0
+    uint64_t drawFrame = 0;      // draw() calls, the clock for mesh recency
     bool firstFrame;
+    std::chrono::steady_clock::time_point startTime;  // construction, for the startup metrics
 
     static constexpr float UNLOAD_DISTANCE = 1500.0f;
+    static constexpr int UNLOAD_MARGIN_RINGS = 7;    // unload window past a longer view distance
     static constexpr float MIN_MOVE_DISTANCE = 20.0f;
     static constexpr int UPDATE_INTERVAL = 8;
+    static constexpr int MAX_NEW_REQUESTS_PER_FRAME = 8;
+    static constexpr int MAX_PREFETCH_REQUESTS_PER_FRAME = 4;
+    static constexpr int PREFETCH_PATH_STEPS = 4;
+    static constexpr float PREFETCH_WEIGHT = 0.1f;  // keeps prefetches behind visible work
+    static constexpr int FIRST_FRAME_RINGS = 1;     // startup blocks until these rings have a mesh
+    static constexpr int MAX_READ_AHEADS_PER_UPDATE = 32;  // cache reads for requests not issued yet
+    static constexpr float COLD_ENCODE_PRIORITY = -1.0f;   // behind every chunk job
+
+    // Hysteresis: the window centre follows the camera chunk only once the
+    // camera is this fraction of a chunk past its edge; a chunk drops to a
+    // coarser LOD one ring past the ring it refined at, and not before it
+    // held its LOD for the residency time
+    static constexpr float CENTER_HYSTERESIS = 0.25f;
+    static constexpr int LOD_HYSTERESIS_RINGS = 1;
+    static constexpr float MIN_LOD_RESIDENCY = 2.0f;  // seconds
+    static constexpr float CHURN_WINDOW = 5.0f;       // seconds, for the churn counters
+
+    // Request importance weights (see requestPriority)
+    static constexpr float OUT_OF_VIEW_WEIGHT = 0.25f;
+    static constexpr float HEADING_WEIGHT = 0.5f;
+
+    // Frustum of the last draw, used to rank requests in update()
+    Frustum lastFrustum;
+    bool hasFrustum = false;
+
+    TerrainStats stats;
+
+    std::shared_ptr<TerrainCache> cache;
+    std::unique_ptr<CacheIO> cacheIO;  // lookups and write-backs, off the pool
+
+    // Unloaded chunks, and their heights still being compressed
+    struct ColdEncode {
+        ChunkKey key;
+        JobHandle<ColdChunkCache::Entry> job;
+    };
+    ColdChunkCache coldChunks;
+    std::vector<ColdEncode> coldEncodes;
+
+    MeshMemoryBudget memoryBudget;
+
+    ChunkPrefetcher prefetcher;
+    std::vector<glm::vec3> predictedPath;  // from the last update, empty when stationary
+
+    struct RequestCandidate {
+        ChunkKey key;
+        int lod;
+        float priority;
+    };
+
+    // Window membership and wanted LOD per chunk, updated incrementally
+    ResidencyTracker residency;
+    ResidencyTracker::Changes residencyChanges;
 
-    std::unordered_map<ChunkKey, TerrainChunk*, ChunkKeyHash> chunks;
-    std::unordered_map<ChunkKey, std::future<MeshData>, ChunkKeyHash> pendingFutures;
-    std::unordered_map<ChunkKey, int, ChunkKeyHash> requestedLod;
-    
-    // CRITICAL: Mutex to protect generator access from multiple threads
-    std::mutex generatorMutex;
+    // Chunk, pending job and requested LOD per coordinate, inline in a
+    // toroidal array covering the unload window
+    ChunkGrid grid;
+
+    // Chunks in the load window whose wanted LOD may still need a request
+    // (flagged in their slot); grows only with window changes,
+    // cancellations and dropped results
+    std::vector<ChunkKey> needsRequest;
+
+    // Slots with a job in flight, so polling does not scan the grid
+    std::vector<ChunkKey> pendingKeys;
+
+    // Slots holding finished meshes that still need a GPU upload
+    std::vector<ChunkKey> uploadKeys;
+
+    // Chunks whose coarsening waits for MIN_LOD_RESIDENCY (flagged in their slot)
+    std::vector<ChunkKey> deferredLods;
+
+    // When chunks left the unload window, for the reload counter; pruned to
+    // the churn window
+    std::unordered_map<ChunkKey, std::chrono::steady_clock::time_point, ChunkKeyHash> recentUnloads;
 
     inline int indexFor(int cx, int cz) {return cz * chunksX + cx;} 
-    int getLODForDistance(float distance);
-    int lodCellsForIndex(int index);
+    int ringsForDistance(float distance) const;
+    std::vector<int> lodRings() const;  // LOD distances rounded down to whole chunk rings
+    static uint64_t apronRingSamples(int cells);
     glm::vec3 getChunkCenterWorld(int cx, int cz);
-    void unloadChunks(const glm::vec3 cameraPos);
+    void applyResidencyChanges();
+
+    // Window centre for a camera position, with CENTER_HYSTERESIS
+    ChunkKey residencyCenter(const glm::vec3& cameraPos) const;
+
+    // Re-evaluates the slot's selected LOD; true if it changed
+    bool selectLod(ChunkSlot& slot, std::chrono::steady_clock::time_point now);
+    void retryDeferredLods(std::chrono::steady_clock::time_point now);
+
+    // Selected LOD of a chunk, or the plain ring LOD if it has none yet
+    int wantedLod(const ChunkKey& key) const;
+    void unloadChunk(ChunkSlot& slot);
+    void stashCold(const ChunkKey& key, TerrainChunk& chunk);
+    void enforceMemoryBudget(const ChunkKey& camKey);
+
+    // Adds or removes a LOD's current sizes in memoryBudget's running
+    // totals; wraps every change to a LOD's CPU copy or mesh
+    void trackLod(const TerrainChunk& c, int lod, bool add);
+    void trackChunk(const TerrainChunk& c, bool add);
+
+    // LOD draw() uses for a chunk: the selected one, else the finest ready
+    int drawLodFor(const ChunkSlot& slot) const;
+    void collectColdEncodes();
+    void markNeedsRequest(const ChunkKey& key);
+
+    // grid.acquire, unloading whatever key still holds the slot
+    ChunkSlot& claimSlot(const ChunkKey& key);
+    void removePending(ChunkSlot& slot);
+    void removeUpload(ChunkSlot& slot);
+    bool lodReady(const ChunkKey& key, int lod) const;
+    void issueRequests(std::vector<RequestCandidate>& candidates, int budget, bool prefetch);
+
+    // Approximate screen-space importance of a chunk: projected size, scaled
+    // down outside the view frustum and behind the camera heading
+    float requestPriority(int cx, int cz, const glm::vec3& cameraPos, const glm::vec3& forward, bool useFrustum = true);
+    void reprioritizePending(const glm::vec3& cameraPos, const glm::vec3& forward);
+
+    void requestChunkAsync(int cx, int cz, int lod, float priority);
+    std::vector<int> cacheLookupSizes(int lod);
+    void writeBack(const ChunkKey& key, uint64_t paramsHash, HeightGrid grid);
+
+    // Cancels jobs whose chunk left the load radius or whose LODs are no
+    // longer the one wanted at the current distance
+    void cancelStaleJobs(const glm::vec3& cameraPos);
+    void cancelJob(ChunkSlot& slot);
+
+    // Whether a pending job produces the LOD the chunk has selected now,
+    // with the hysteresis of the window centre and of the LOD choice
+    bool jobWanted(const ChunkKey& key, const PendingChunk& pending) const;
+
+    // Same for a camera at `position` (a predicted path point), from the
+    // plain rings
+    bool jobWantedAt(const ChunkKey& key, const PendingChunk& pending, const glm::vec3& position) const;
+    static bool jobCovers(const PendingChunk& pending, int lod);
+
+    // Low-priority requests for chunks the predicted path will need
+    void prefetchAhead(const glm::vec3& cameraPos);
+    float predictedUpdateDelay(float dt) const;
+    void finalizeReadyJobs();
 
-    void requestChunkAsync(int cx, int cz, int lod);
-    void finalizeReadyFutures();
+    // Turns queued meshes into GPU meshes, most visible first, within the
+    // per-frame byte and time budget
+    void uploadReadyMeshes(const glm::vec3& cameraPos, const glm::vec3& forward);
 };
 
 #endif
\ No newline at end of file
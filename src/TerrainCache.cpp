@@ -1,9 +1,103 @@
+#include "TerrainCache.h"
+#include <cstdio>
+#include <cstring>
 
+namespace {
+    // Bumped whenever the stored heights would differ for the same params
+    constexpr uint64_t HASH_VERSION = 4;
 
+    inline uint64_t mix(uint64_t h, uint64_t v){
+        // splitmix64 finalizer over the running hash
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
 
-#include "TerrainCache.h"
+    inline uint64_t floatBits(float f){
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+}
+
+
+TerrainCache::TerrainCache(std::string directory, float precision_)
+    : root(std::move(directory)), precision(precision_)
+{
+}
+
+uint64_t TerrainCache::paramsHash(const TerrainGenerator::Params& p, float worldScale){
+    uint64_t h = HASH_VERSION;
+    h = mix(h, floatBits(p.baseFrequency));
+    h = mix(h, uint64_t(uint32_t(p.octaves)));
+    h = mix(h, floatBits(p.persistence));
+    h = mix(h, floatBits(p.lacunarity));
+    h = mix(h, floatBits(p.heightScale));
+    h = mix(h, p.seed);
+    h = mix(h, uint64_t(p.noise));
+    h = mix(h, floatBits(worldScale));
+    return h;
+}
+
+std::string TerrainCache::filename(uint64_t paramsHash, int cx, int cz) const{
+    char name[96];
+    std::snprintf(name, sizeof(name), "%016llx/r.%d.%d.region", (unsigned long long)paramsHash,
+        RegionFile::regionCoord(cx), RegionFile::regionCoord(cz));
+    return root + "/" + name;
+}
+
+std::shared_ptr<RegionFile> TerrainCache::region(uint64_t paramsHash, int cx, int cz, bool create){
+    const int rx = RegionFile::regionCoord(cx);
+    const int rz = RegionFile::regionCoord(cz);
+    const auto id = std::make_tuple(paramsHash, rx, rz);
+
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    auto it = regions.find(id);
+    if(it != regions.end() && (it->second || !create)) return it->second;
+
+    // Long sessions cross many regions; close the ones nobody is using
+    if(regions.size() >= MAX_OPEN_REGIONS){
+        for(auto r = regions.begin(); r != regions.end();){
+            if(r->second.use_count() <= 1) r = regions.erase(r);
+            else ++r;
+        }
+    }
+
+    // A missing file is remembered too, so misses in unvisited regions do
+    // not hit the filesystem every time
+    std::shared_ptr<RegionFile> file = RegionFile::open(filename(paramsHash, cx, cz), paramsHash, rx, rz, create);
+    regions[id] = file;
+    return file;
+}
+
+bool TerrainCache::loadHeightMap(uint64_t paramsHash, int cx, int cz, int cellsPerSide, HeightGrid& out){
+    std::shared_ptr<RegionFile> file = region(paramsHash, cx, cz, false);
+    if(!file || !file->read(cx, cz, cellsPerSide, out)){
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    hitCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
 
+bool TerrainCache::saveHeightMap(uint64_t paramsHash, int cx, int cz, const HeightGrid& grid){
+    std::shared_ptr<RegionFile> file = region(paramsHash, cx, cz, true);
+    size_t bytes = 0;
+    if(!file || !file->write(cx, cz, grid, precision, &bytes)) return false;
 
-std::string TerrainCache::filename(int cx, int cz){
+    writeCount.fetch_add(1, std::memory_order_relaxed);
+    writtenBytes.fetch_add(bytes, std::memory_order_relaxed);
+    return true;
+}
 
-}
\ No newline at end of file
+TerrainCache::Stats TerrainCache::getStats() const{
+    Stats s;
+    s.hits = hitCount.load(std::memory_order_relaxed);
+    s.misses = missCount.load(std::memory_order_relaxed);
+    s.writes = writeCount.load(std::memory_order_relaxed);
+    s.bytesWritten = writtenBytes.load(std::memory_order_relaxed);
+    return s;
+}
@@ -1,15 +1,67 @@
 #ifndef TERRAIN_CACHE_H
 #define TERRAIN_CACHE_H
 
+#include "HeightCodec.h"
+#include "RegionFile.h"
+#include "TerrainGenerator.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <vector>
+#include <tuple>
 
 
-namespace TerrainCache{
-    std::string filename(int cx, int cz);
-    bool loadHeightMap(int cx, int cz, int cellsPerSide, std::vector<float>& outHeights);
-    bool saveHeightMap(int cx, int cz, int cellsPerSide, const std::vector<float>& heights);
+// On-disk store of generated height grids (apron included), packed into
+// RegionFiles of 32x32 chunks under a directory named after the parameter
+// hash, so changing any generator parameter starts from an empty cache.
+// Loads and saves may run on any thread; see RegionFile for the rules.
+class TerrainCache{
+public:
+    struct Stats{
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t writes = 0;
+        uint64_t bytesWritten = 0;
+    };
+
+    // Heights are stored to a multiple of `precision` world units
+    explicit TerrainCache(std::string directory, float precision = HeightCodec::DEFAULT_PRECISION);
+
+    // Everything that changes the generated heights
+    static uint64_t paramsHash(const TerrainGenerator::Params& p, float worldScale);
+
+    // Region file holding the chunk
+    std::string filename(uint64_t paramsHash, int cx, int cz) const;
+
+    // False (and out untouched) on a miss or a damaged file
+    bool loadHeightMap(uint64_t paramsHash, int cx, int cz, int cellsPerSide, HeightGrid& out);
+    bool saveHeightMap(uint64_t paramsHash, int cx, int cz, const HeightGrid& grid);
+
+    Stats getStats() const;
+
+    // Region file holding the chunk, opened on first use; nullptr if it
+    // does not exist (and create is false)
+    std::shared_ptr<RegionFile> region(uint64_t paramsHash, int cx, int cz, bool create);
+
+    float getPrecision() const { return precision; }
+
+private:
+    static constexpr size_t MAX_OPEN_REGIONS = 64;
+
+    std::string root;
+    float precision;
+
+    // Open regions, and regions known to have no file yet (nullptr)
+    std::mutex regionsMutex;
+    std::map<std::tuple<uint64_t, int, int>, std::shared_ptr<RegionFile>> regions;
+
+    std::atomic<uint64_t> hitCount{0};
+    std::atomic<uint64_t> missCount{0};
+    std::atomic<uint64_t> writeCount{0};
+    std::atomic<uint64_t> writtenBytes{0};
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -1,25 +1,19 @@
 #include "TerrainChunk.h"
+#include <cmath>
 #include <limits>
 
 // Full constructor - no longer generates LODs automatically
-TerrainChunk::TerrainChunk(int cx, int cz, TerrainGenerator& gen, int cellsPerSide, float m_worldScale)
-    : chunkX(cx), chunkZ(cz), baseCellsPerSide(cellsPerSide), worldScale(m_worldScale)
+TerrainChunk::TerrainChunk(int cx, int cz, TerrainGenerator& gen, int cellsPerSide, float m_worldScale, int lodCount)
+    : chunkX(cx), chunkZ(cz), baseCellsPerSide(cellsPerSide), worldScale(m_worldScale), lodReady(lodCount, false)
 {
-    for(int i = 0; i < 3; i++) {
-        lodReady[i] = false;
-    }
-    
     // NOTE: We no longer auto-generate LODs here. 
     // The Terrain class will call buildLodFromData() when mesh data is ready.
 }
 
 // Minimal constructor for async chunk creation
-TerrainChunk::TerrainChunk(int cx, int cz)
-    : chunkX(cx), chunkZ(cz), baseCellsPerSide(0), worldScale(1.0f)
+TerrainChunk::TerrainChunk(int cx, int cz, int lodCount)
+    : chunkX(cx), chunkZ(cz), baseCellsPerSide(0), worldScale(1.0f), lodReady(lodCount, false)
 {
-    for(int i = 0; i < 3; ++i){
-        lodReady[i] = false;
-    }
 }
 
 TerrainChunk::~TerrainChunk()
@@ -34,16 +28,18 @@ TerrainChunk::~TerrainChunk()
     lodMap.clear();
 }
 
-LodMeshInfo TerrainChunk::buildLod(TerrainGenerator& gen, int cellsPerSide)
+LodMeshInfo TerrainChunk::buildLod(const TerrainGenerator& gen, int cellsPerSide)
 {
     LodMeshInfo info;
     info.data = gen.generateChunk(chunkX, chunkZ, cellsPerSide, worldScale);
+    info.generatorVersion = gen.getVersion();
     computeBounds(info.data, info.minBounds, info.maxBounds);
     info.mesh = new Mesh(info.data);
+    info.gpuBytes = info.data.verticesCount() * sizeof(TerrainVertex);
     return info;
 }
 
-void TerrainChunk::buildLodFromData(MeshData& m_data, int lodIndex){
+void TerrainChunk::buildLodFromData(MeshData& m_data, int lodIndex, uint64_t generatorVersion){
     // IMPORTANT: Don't rebuild if this LOD already exists
     // This prevents overwriting LODs that are still being used
     if (lodReady[lodIndex] && lodMap.count(lodIndex) > 0) {
@@ -53,14 +49,16 @@ void TerrainChunk::buildLodFromData(MeshData& m_data, int lodIndex){
     
     LodMeshInfo info;
     info.data = std::move(m_data);  // Use move semantics for efficiency
+    info.generatorVersion = generatorVersion;
     computeBounds(info.data, info.minBounds, info.maxBounds);
     info.mesh = new Mesh(info.data);
+    info.gpuBytes = info.data.verticesCount() * sizeof(TerrainVertex);
 
     lodMap[lodIndex] = std::move(info);
     lodReady[lodIndex] = true;
 }
 
-void TerrainChunk::regenerate(TerrainGenerator& gen, int lodIndex, int cells)
+void TerrainChunk::regenerate(const TerrainGenerator& gen, int lodIndex, int cells)
 {
     auto it = lodMap.find(lodIndex);
     if (it != lodMap.end()) {
@@ -72,8 +70,10 @@ void TerrainChunk::regenerate(TerrainGenerator& gen, int lodIndex, int cells)
         
         // Generate new data
         it->second.data = gen.generateChunk(chunkX, chunkZ, cells, worldScale);
+        it->second.generatorVersion = gen.getVersion();
         computeBounds(it->second.data, it->second.minBounds, it->second.maxBounds);
         it->second.mesh = new Mesh(it->second.data);
+        it->second.gpuBytes = it->second.data.verticesCount() * sizeof(TerrainVertex);
         lodReady[lodIndex] = true;
     } else {
         // Create new LOD
@@ -85,22 +85,72 @@ void TerrainChunk::regenerate(TerrainGenerator& gen, int lodIndex, int cells)
 std::vector<float> TerrainChunk::exportHeights() const
 {
     std::vector<float> heights;
-    
-    // Prefer highest LOD (index 0)
-    const LodMeshInfo* info = getLodInfo(0);
-    if (!info && !lodMap.empty()) {
-        info = &lodMap.begin()->second;
-    }
+
+    // Uploaded LODs may have released their vertices
+    const LodMeshInfo* info = finestLod();
     if (!info) return heights;
 
     heights.reserve(info->data.vertices.size());
-    for (const auto &v : info->data.vertices) {
-        heights.push_back(v.position.y);
+    for (size_t i = 0; i < info->data.vertices.size(); ++i) {
+        heights.push_back(info->data.heightAt(i));
     }
     return heights;
 }
 
-void TerrainChunk::draw(int lodIndex, bool wireframe) const
+std::vector<uint8_t> TerrainChunk::exportCompressed(float precision) const
+{
+    std::vector<uint8_t> out;
+    std::vector<float> heights = exportHeights();
+    int side = static_cast<int>(std::lround(std::sqrt(double(heights.size()))));
+    if (heights.empty() || size_t(side) * size_t(side) != heights.size()) return out;
+
+    HeightCodec::encode(heights.data(), side, side, precision, out);
+    return out;
+}
+
+HeightGrid TerrainChunk::finerHeights(int lodIndex) const
+{
+    for (int lod = lodIndex - 1; lod >= 0; --lod) {
+        const LodMeshInfo* info = getLodInfo(lod);
+        if (info && !info->data.vertices.empty()) {
+            return HeightGrid::fromMesh(info->data);
+        }
+    }
+    return HeightGrid();
+}
+
+void TerrainChunk::evictLod(int lodIndex)
+{
+    auto it = lodMap.find(lodIndex);
+    if (it == lodMap.end()) return;
+
+    delete it->second.mesh;
+    lodMap.erase(it);
+    lodReady[lodIndex] = false;
+}
+
+void TerrainChunk::releaseCpuData(int lodIndex)
+{
+    auto it = lodMap.find(lodIndex);
+    if (it == lodMap.end()) return;
+    std::vector<TerrainVertex>().swap(it->second.data.vertices);
+}
+
+LodMeshInfo* TerrainChunk::finestLod()
+{
+    return const_cast<LodMeshInfo*>(static_cast<const TerrainChunk*>(this)->finestLod());
+}
+
+const LodMeshInfo* TerrainChunk::finestLod() const
+{
+    for (int lod = 0; lod < lodCount(); ++lod) {
+        auto it = lodMap.find(lod);
+        if (it != lodMap.end() && !it->second.data.vertices.empty()) return &it->second;
+    }
+    return nullptr;
+}
+
+void TerrainChunk::draw(const Shader& shader, int lodIndex, bool wireframe) const
 {
     if (wireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -112,7 +162,7 @@ void TerrainChunk::draw(int lodIndex, bool wireframe) const
     auto it = lodMap.find(lodIndex);
     if (it == lodMap.end()) {
         // Fallback: try to find ANY available LOD
-        for (int fallbackLod = 0; fallbackLod < 3; ++fallbackLod) {
+        for (int fallbackLod = 0; fallbackLod < lodCount(); ++fallbackLod) {
             it = lodMap.find(fallbackLod);
             if (it != lodMap.end() && it->second.mesh) {
                 break;
@@ -127,6 +177,12 @@ void TerrainChunk::draw(int lodIndex, bool wireframe) const
 
     const LodMeshInfo &info = it->second;
     if (info.mesh) {
+        // Grid placement and height range to decode the packed vertices
+        shader.setVec2("uChunkOrigin", glm::vec2(info.data.originX, info.data.originZ));
+        shader.setFloat("uCellSpacing", info.data.spacing);
+        shader.setInt("uCellsPerSide", info.data.cellsPerSide);
+        shader.setFloat("uHeightMin", info.data.heightMin);
+        shader.setFloat("uHeightRange", info.data.heightRange);
         info.mesh->draw();
     }
 
@@ -140,22 +196,23 @@ void TerrainChunk::computeBounds(const MeshData& data, glm::vec3& minBounds, glm
         return;
     }
 
-    minBounds = glm::vec3(std::numeric_limits<float>::max());
-    maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
-
+    // x/z follow from the grid, only the heights need scanning
+    uint16_t qMin = std::numeric_limits<uint16_t>::max();
+    uint16_t qMax = 0;
     for (const auto &v : data.vertices) {
-        minBounds.x = std::min(minBounds.x, v.position.x);
-        minBounds.y = std::min(minBounds.y, v.position.y);
-        minBounds.z = std::min(minBounds.z, v.position.z);
-
-        maxBounds.x = std::max(maxBounds.x, v.position.x);
-        maxBounds.y = std::max(maxBounds.y, v.position.y);
-        maxBounds.z = std::max(maxBounds.z, v.position.z);
+        qMin = std::min(qMin, v.height);
+        qMax = std::max(qMax, v.height);
     }
+
+    const float extent = (data.cellsPerSide - 1) * data.spacing;
+    const float step = data.heightRange / 65535.0f;
+
+    minBounds = glm::vec3(data.originX, data.heightMin + qMin * step, data.originZ);
+    maxBounds = glm::vec3(data.originX + extent, data.heightMin + qMax * step, data.originZ + extent);
 }
 
 void TerrainChunk::setLodMesh(MeshData data, int lodIndex){
-    if(lodIndex < 0 || lodIndex > 2) return;
+    if(lodIndex < 0 || lodIndex >= lodCount()) return;
     
     // Clean up existing mesh if any
     auto it = lodMap.find(lodIndex);
@@ -167,6 +224,7 @@ void TerrainChunk::setLodMesh(MeshData data, int lodIndex){
     info.data = std::move(data);
     computeBounds(info.data, info.minBounds, info.maxBounds);
     info.mesh = new Mesh(info.data);
+    info.gpuBytes = info.data.verticesCount() * sizeof(TerrainVertex);
     
     lodMap[lodIndex] = std::move(info);
     lodReady[lodIndex] = true;
@@ -2,19 +2,25 @@
 #define TERRAIN_CHUNK_H
 
 #include "Mesh.h"
+#include "Shader.h"
+#include "HeightCodec.h"
 #include "TerrainGenerator.h"
 #include <unordered_map>
 #include <vector>
 #include <memory>
 
 struct LodMeshInfo {
-    MeshData data;      // CPU-side data (vertices + indices + skirt ranges)
-    Mesh* mesh = nullptr; // GPU mesh (owns VBO/EBO/VAO) - will be deleted by TerrainChunk
+    MeshData data;      // CPU-side data (packed vertices + grid placement)
+    Mesh* mesh = nullptr; // GPU mesh (owns VBO/VAO, binds the shared EBO) - will be deleted by TerrainChunk
     glm::vec3 minBounds = glm::vec3(0.0f);
     glm::vec3 maxBounds = glm::vec3(0.0f);
+    uint64_t generatorVersion = 0; // snapshot the heights came from
+    size_t gpuBytes = 0;           // vertex buffer size
+    uint64_t lastUsedFrame = 0;    // last frame this LOD was chosen for drawing
 
-    // convenience
-    bool valid() const { return mesh != nullptr && !data.vertices.empty(); }
+    // convenience; data.vertices may have been released, see releaseCpuData()
+    bool valid() const { return mesh != nullptr; }
+    size_t cpuBytes() const { return data.vertices.capacity() * sizeof(TerrainVertex); }
 };
 
 class TerrainChunk {
@@ -24,18 +30,32 @@ public:
     int baseCellsPerSide = 0; // the highest LOD cellsPerSide used when chunk was created
     float worldScale = 1.0f;
 
-    bool lodReady[3];
+    std::vector<bool> lodReady;  // one entry per level of the LOD chain
     std::unordered_map<int, LodMeshInfo> lodMap;
 
-    TerrainChunk(int cx, int cz, TerrainGenerator& gen, int cellsPerSide, float worldScale);
-    TerrainChunk(int cx, int cz);
+    TerrainChunk(int cx, int cz, TerrainGenerator& gen, int cellsPerSide, float worldScale, int lodCount = 3);
+    TerrainChunk(int cx, int cz, int lodCount);
+
+    int lodCount() const { return static_cast<int>(lodReady.size()); }
     ~TerrainChunk();
 
-    void regenerate(TerrainGenerator& gen, int lodIndex, int cells);
+    void regenerate(const TerrainGenerator& gen, int lodIndex, int cells);
 
+    // Heights of the finest LOD that still has its CPU copy; empty when
+    // every LOD's copy was released (see releaseCpuData())
     std::vector<float> exportHeights() const;
 
-    void draw(int lodIndex, bool wireframe = false) const;
+    // exportHeights() through HeightCodec; empty if there is nothing to export
+    std::vector<uint8_t> exportCompressed(float precision = HeightCodec::DEFAULT_PRECISION) const;
+
+    // Heights of the coarsest resident LOD finer than lodIndex, empty if none
+    HeightGrid finerHeights(int lodIndex) const;
+
+    // The finest LOD with CPU data, nullptr if none
+    LodMeshInfo* finestLod();
+    const LodMeshInfo* finestLod() const;
+
+    void draw(const Shader& shader, int lodIndex, bool wireframe = false) const;
 
     static void computeBounds(const MeshData& data, glm::vec3& outMin, glm::vec3& outMax);
 
@@ -45,15 +65,23 @@ public:
         return (it == lodMap.end()) ? nullptr : &it->second;
     }
 
-    void buildLodFromData(MeshData& m_data, int lodIndex);
+    void buildLodFromData(MeshData& m_data, int lodIndex, uint64_t generatorVersion = 0);
 
     void setLodMesh(MeshData data, int lod);
 
+    // Drops a LOD's mesh and CPU data
+    void evictLod(int lodIndex);
+
+    // Frees the CPU copy of an uploaded LOD. Drawing only needs the mesh
+    // and the grid placement, which stay; finerHeights() and the exports
+    // skip LODs without vertices.
+    void releaseCpuData(int lodIndex);
+
     glm::vec3 getMin(int lod) const;
     glm::vec3 getMax(int lod) const;
 
 private:
-    LodMeshInfo buildLod(TerrainGenerator& gen, int cellsPerSide);
+    LodMeshInfo buildLod(const TerrainGenerator& gen, int cellsPerSide);
 };
 
 #endif
@@ -1,179 +1,299 @@
 #include "TerrainGenerator.h"
-#include <glm/gtc/noise.hpp>
+#include <algorithm>
+#include <cmath>
+
+TerrainGenerator::TerrainGenerator()
+    : current(std::make_shared<const Snapshot>(Params(), 1))
+{
+}
 
 TerrainGenerator::TerrainGenerator(const Params& p)
-    : params(p), rng(p.seed), dist(0.0, 1.0)
+    : current(std::make_shared<const Snapshot>(p, 1))
 {
 }
 
 void TerrainGenerator::setParams(const Params& p){
-    params = p;
-    rng.seed(params.seed);
+    SnapshotPtr next = std::make_shared<const Snapshot>(p, getVersion() + 1);
+    std::atomic_store(&current, next);
 }
 
-const TerrainGenerator::Params& TerrainGenerator::getParams() const {
-    return params;
+TerrainGenerator::Params TerrainGenerator::getParams() const {
+    return snapshot()->getParams();
 }
 
-float TerrainGenerator::fractalPerlin(float x, float z) const{
-    float amplitude = 1.0f;
-    float frequency = params.baseFrequency;
-    float total = 0.0f;
-    float maxAmp = 0.0f;
+TerrainGenerator::SnapshotPtr TerrainGenerator::snapshot() const {
+    return std::atomic_load(&current);
+}
 
-    for(int o = 0; o < params.octaves; ++o){
-        // glm::perlin is thread-safe (pure function, no state)
-        float n = glm::perlin(glm::vec2(x * frequency, z * frequency));
-        
-        total += n * amplitude;
-        maxAmp += amplitude;
-        amplitude *= params.persistence;
-        frequency *= params.lacunarity;
-    }
-  
-    if(maxAmp > 0.0f) {
-        total /= maxAmp; // normalize to [-1,1]
-    }
-    return total;
+uint64_t TerrainGenerator::getVersion() const {
+    return snapshot()->getVersion();
+}
+
+MeshData TerrainGenerator::generateChunk(int chunkX, int chunkZ, int cellsPerSide, float worldScale) const {
+    return snapshot()->generateChunk(chunkX, chunkZ, cellsPerSide, worldScale);
 }
 
 float TerrainGenerator::getHeightAt(float worldX, float worldZ) const {
-    float n = fractalPerlin(worldX, worldZ);
-    return n * params.heightScale;
+    return snapshot()->getHeightAt(worldX, worldZ);
 }
 
-MeshData TerrainGenerator::generateChunk(int chunkX, int chunkZ, int cellsPerSide, float worldScale)
+HeightGrid HeightGrid::decimated(int cells) const{
+    HeightGrid out;
+    if (cells <= 1 || (cellsPerSide - 1) % (cells - 1) != 0) return out;
+
+    const int step = (cellsPerSide - 1) / (cells - 1);
+
+    // The apron survives only if this grid's apron reaches one coarse step out
+    out.cellsPerSide = cells;
+    out.apron = (apron >= step) ? 1 : 0;
+    const int n = out.stride();
+    out.heights.resize(size_t(n) * size_t(n));
+    for (int row = -out.apron; row < cells + out.apron; ++row) {
+        for (int col = -out.apron; col < cells + out.apron; ++col) {
+            out.heights[size_t(row + out.apron) * n + (col + out.apron)] = at(row * step, col * step);
+        }
+    }
+    return out;
+}
+
+HeightGrid HeightGrid::fromMesh(const MeshData& data){
+    HeightGrid out;
+    int cells = static_cast<int>(std::lround(std::sqrt(double(data.vertices.size()))));
+    if (size_t(cells) * size_t(cells) != data.vertices.size()) return out;
+
+    out.cellsPerSide = cells;
+    out.apron = 0;
+    out.heights.reserve(data.vertices.size());
+    for (size_t i = 0; i < data.vertices.size(); ++i) {
+        out.heights.push_back(data.heightAt(i));
+    }
+    return out;
+}
+
+TerrainGenerator::Snapshot::Snapshot(const Params& p, uint64_t version_)
+    : params(p), version(version_), noise(createNoiseBackend(p.noise, p.seed))
 {
-    MeshData out;
+    fractal.baseFrequency = p.baseFrequency;
+    fractal.octaves = p.octaves;
+    fractal.persistence = p.persistence;
+    fractal.lacunarity = p.lacunarity;
+    fractal.heightScale = p.heightScale;
+}
 
-    const int fullCells = HIGH_LOD_CELLS;                   
-    const float fullSize = (fullCells - 1) * worldScale;
+float TerrainGenerator::Snapshot::heightMin() const {
+    return -HEIGHT_QUANT_SPAN * params.heightScale;
+}
 
-    // Allocate memory upfront
-    const size_t numVertices = size_t(cellsPerSide) * size_t(cellsPerSide);
-    const size_t numIndices  = size_t(cellsPerSide - 1) * size_t(cellsPerSide - 1) * 6;
+float TerrainGenerator::Snapshot::heightRange() const {
+    return 2.0f * HEIGHT_QUANT_SPAN * params.heightScale;
+}
 
-    out.vertices.resize(numVertices);
-    out.indices.resize(numIndices);
+float TerrainGenerator::Snapshot::getHeightAt(float worldX, float worldZ) const {
+    // Same backend path as generateChunk, so the results match exactly
+    return noise->fractalHeight(fractal, worldX, worldZ);
+}
 
-    // LOD visualization colors
-    glm::vec3 greenColor(0.15f, 0.2f, 0.12f);
-    glm::vec3 lodColor = glm::mix(
-        glm::vec3(1.0f, 0.0f, 0.0f), 
-        glm::vec3(0.0f, 1.0f, 0.0f),
-        glm::clamp((cellsPerSide - 17.0f) / (65.0f - 17.0f), 0.0f, 1.0f)
-    );
+void TerrainGenerator::Snapshot::sampleHeights(const float* worldX, const float* worldZ, float* out, size_t count) const {
+    noise->fractalHeights(fractal, worldX, worldZ, out, count);
+}
 
-    float chunkOriginX = chunkX * fullSize;
-    float chunkOriginZ = chunkZ * fullSize;
+MeshData TerrainGenerator::Snapshot::generateChunk(int chunkX, int chunkZ, int cellsPerSide, float worldScale) const
+{
+    HeightGrid grid = generateHeights(chunkX, chunkZ, cellsPerSide, worldScale);
+    return buildMesh(chunkX, chunkZ, grid, worldScale);
+}
 
-    // ------------- Vertices ---------------------
-    #pragma omp parallel for collapse(2)
-    for(int row = 0; row < cellsPerSide; ++row)
+std::vector<MeshData> TerrainGenerator::Snapshot::generateLodChain(int chunkX, int chunkZ, const std::vector<int>& cellsPerLod, float worldScale,
+    const std::atomic<bool>* cancelled) const
+{
+    if (cellsPerLod.empty()) return std::vector<MeshData>();
+
+    // Only the finest grid is fully evaluated; nested grids sample the same
+    // world positions, so decimating gives exactly the heights they would
+    // have been generated with. Coarser LODs only evaluate their apron ring.
+    HeightGrid finest = generateHeights(chunkX, chunkZ, cellsPerLod.front(), worldScale, cancelled);
+    return buildLodChain(chunkX, chunkZ, finest, cellsPerLod, worldScale, cancelled);
+}
+
+std::vector<MeshData> TerrainGenerator::Snapshot::buildLodChain(int chunkX, int chunkZ, const HeightGrid& finest,
+    const std::vector<int>& cellsPerLod, float worldScale, const std::atomic<bool>* cancelled) const
+{
+    std::vector<MeshData> out;
+    if (cellsPerLod.empty() || finest.empty()) return out;
+
+    out.reserve(cellsPerLod.size());
+    out.push_back(buildMesh(chunkX, chunkZ, finest, worldScale));
+    for (size_t i = 1; i < cellsPerLod.size(); ++i) {
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+            out.clear();
+            return out;
+        }
+        HeightGrid coarse = completeApron(chunkX, chunkZ, finest.decimated(cellsPerLod[i]), worldScale);
+        out.push_back(buildMesh(chunkX, chunkZ, coarse, worldScale));
+    }
+    return out;
+}
+
+HeightGrid TerrainGenerator::Snapshot::generateHeights(int chunkX, int chunkZ, int cellsPerSide, float worldScale,
+    const std::atomic<bool>* cancelled) const
+{
+    const float fullSize = (HIGH_LOD_CELLS - 1) * worldScale;
+    return generateRegionHeights(chunkX * fullSize, chunkZ * fullSize, fullSize, cellsPerSide, cancelled);
+}
+
+HeightGrid TerrainGenerator::Snapshot::generateRegionHeights(float chunkOriginX, float chunkOriginZ, float fullSize,
+    int cellsPerSide, const std::atomic<bool>* cancelled) const
+{
+    HeightGrid grid;
+    grid.cellsPerSide = cellsPerSide;
+    grid.apron = 1;
+    const int n = grid.stride();
+    grid.heights.resize(size_t(n) * size_t(n));
+
+    // Heights are evaluated one row at a time through the backend's batch
+    // path. Apron samples use the same spacing and land exactly on the
+    // neighbouring chunk's edge samples.
+    #pragma omp parallel for
+    for(int row = -1; row <= cellsPerSide; ++row)
     {
-        for(int col = 0; col < cellsPerSide; ++col)
-        {
-            float u = col / float(cellsPerSide - 1);
-            float v = row / float(cellsPerSide - 1);
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) continue;
 
-            float wx = chunkOriginX + u * fullSize;
-            float wz = chunkOriginZ + v * fullSize;
+        std::vector<float> rowX(n), rowZ(n);
+        float v = row / float(cellsPerSide - 1);
+        float wz = chunkOriginZ + v * fullSize;
 
-            float h = getHeightAt(wx, wz);
+        for(int col = -1; col <= cellsPerSide; ++col)
+        {
+            float u = col / float(cellsPerSide - 1);
+            rowX[col + 1] = chunkOriginX + u * fullSize;
+            rowZ[col + 1] = wz;
+        }
+        noise->fractalHeights(fractal, rowX.data(), rowZ.data(), &grid.heights[size_t(row + 1) * n], n);
+    }
 
-            Vertex vtx;
-            vtx.position = glm::vec3(wx, h, wz);
+    if (cancelled && cancelled->load(std::memory_order_relaxed)) return HeightGrid();
+    return grid;
+}
 
-            // Color based on height
-            float t = glm::clamp((h / params.heightScale + 1.0f) * 0.5f, 0.0f, 1.0f);
-            vtx.color = glm::mix(greenColor, lodColor, t);
+HeightGrid TerrainGenerator::Snapshot::completeApron(int chunkX, int chunkZ, const HeightGrid& interior, float worldScale) const
+{
+    if (interior.apron >= 1 || interior.empty()) return interior;
+
+    const int cells = interior.cellsPerSide;
+    HeightGrid grid;
+    grid.cellsPerSide = cells;
+    grid.apron = 1;
+    const int n = grid.stride();
+    grid.heights.resize(size_t(n) * size_t(n));
+
+    for (int row = 0; row < cells; ++row) {
+        for (int col = 0; col < cells; ++col) {
+            grid.heights[size_t(row + 1) * n + (col + 1)] = interior.at(row, col);
+        }
+    }
 
-            vtx.normal = glm::vec3(0.0f);  // Will be computed later
-            vtx.texCoord = glm::vec2(u, v);
+    const float fullSize = (HIGH_LOD_CELLS - 1) * worldScale;
+    float chunkOriginX = chunkX * fullSize;
+    float chunkOriginZ = chunkZ * fullSize;
 
-            size_t idx = row * cellsPerSide + col;
-            out.vertices[idx] = vtx;
+    // Ring of 4 * (cells + 1) samples around the interior
+    std::vector<int> slots;
+    std::vector<float> xs, zs;
+    slots.reserve(4 * (cells + 1));
+    for (int row = -1; row <= cells; ++row) {
+        for (int col = -1; col <= cells; ++col) {
+            bool edge = row == -1 || row == cells || col == -1 || col == cells;
+            if (!edge) continue;
+
+            slots.push_back((row + 1) * n + (col + 1));
+            xs.push_back(chunkOriginX + (col / float(cells - 1)) * fullSize);
+            zs.push_back(chunkOriginZ + (row / float(cells - 1)) * fullSize);
         }
     }
 
-    // ------------- Indices ---------------------
-    #pragma omp parallel for collapse(2)
-    for(int row = 0; row < cellsPerSide - 1; ++row)
+    std::vector<float> hs(slots.size());
+    noise->fractalHeights(fractal, xs.data(), zs.data(), hs.data(), hs.size());
+    for (size_t i = 0; i < slots.size(); ++i) {
+        grid.heights[slots[i]] = hs[i];
+    }
+    return grid;
+}
+
+MeshData TerrainGenerator::Snapshot::buildMesh(int chunkX, int chunkZ, const HeightGrid& grid, float worldScale) const
+{
+    const int fullCells = HIGH_LOD_CELLS;                   
+    const float fullSize = (fullCells - 1) * worldScale;
+    return buildRegionMesh(chunkX * fullSize, chunkZ * fullSize, fullSize, grid);
+}
+
+MeshData TerrainGenerator::Snapshot::buildRegionMesh(float chunkOriginX, float chunkOriginZ, float fullSize, const HeightGrid& grid) const
+{
+    MeshData out;
+
+    const int cellsPerSide = grid.cellsPerSide;
+
+    // Allocate memory upfront
+    const size_t numVertices = size_t(cellsPerSide) * size_t(cellsPerSide);
+
+    out.vertices.resize(numVertices);
+
+    out.cellsPerSide = cellsPerSide;
+    out.originX = chunkOriginX;
+    out.originZ = chunkOriginZ;
+    out.spacing = fullSize / float(cellsPerSide - 1);
+    out.heightMin = heightMin();
+    out.heightRange = heightRange();
+
+    // ------------- Vertices ---------------------
+    // Only the quantized height is stored; x/z follow from the grid
+    #pragma omp parallel for
+    for(int row = 0; row < cellsPerSide; ++row)
     {
-        for(int col = 0; col < cellsPerSide - 1; ++col)
+        for(int col = 0; col < cellsPerSide; ++col)
         {
-            size_t idxBase = (row * (cellsPerSide - 1) + col) * 6;
-
-            uint32_t tl = row * cellsPerSide + col;
-            uint32_t tr = tl + 1;
-            uint32_t bl = (row + 1) * cellsPerSide + col;
-            uint32_t br = bl + 1;
-
-            // Triangle 1
-            out.indices[idxBase]     = tl;
-            out.indices[idxBase + 1] = bl;
-            out.indices[idxBase + 2] = tr;
-
-            // Triangle 2
-            out.indices[idxBase + 3] = tr;
-            out.indices[idxBase + 4] = bl;
-            out.indices[idxBase + 5] = br;
+            size_t idx = size_t(row) * cellsPerSide + col;
+            out.vertices[idx].height = out.quantizeHeight(grid.at(row, col));
         }
     }
 
     // ------------- Normal Calculation ---------------------
-    // Accumulate face normals, then normalize per-vertex
-    std::vector<glm::vec3> tempNormals(numVertices, glm::vec3(0.0f));
+    // Central differences on the height grid. The apron supplies the samples
+    // beyond the edges, so border normals match the neighbouring chunk. Each
+    // vertex is independent: no atomics, same result for any thread count.
+    const float spacing = out.spacing;
+    const int last = cellsPerSide - 1;
+    const bool hasApron = grid.apron >= 1;
 
     #pragma omp parallel for
-    for(size_t i = 0; i < out.indices.size(); i += 3)
+    for(int row = 0; row < cellsPerSide; ++row)
     {
-        uint32_t ia = out.indices[i];
-        uint32_t ib = out.indices[i + 1];
-        uint32_t ic = out.indices[i + 2];
-
-        glm::vec3 A = out.vertices[ia].position;
-        glm::vec3 B = out.vertices[ib].position;
-        glm::vec3 C = out.vertices[ic].position;
-
-        glm::vec3 edge1 = B - A;
-        glm::vec3 edge2 = C - A;
-        glm::vec3 N = glm::cross(edge1, edge2);
-        
-        // Don't normalize yet - we want weighted average
-        // (larger triangles contribute more)
-
-        // Atomic operations for thread safety
-        #pragma omp atomic
-        tempNormals[ia].x += N.x;
-        #pragma omp atomic
-        tempNormals[ia].y += N.y;
-        #pragma omp atomic
-        tempNormals[ia].z += N.z;
-
-        #pragma omp atomic
-        tempNormals[ib].x += N.x;
-        #pragma omp atomic
-        tempNormals[ib].y += N.y;
-        #pragma omp atomic
-        tempNormals[ib].z += N.z;
-
-        #pragma omp atomic
-        tempNormals[ic].x += N.x;
-        #pragma omp atomic
-        tempNormals[ic].y += N.y;
-        #pragma omp atomic
-        tempNormals[ic].z += N.z;
-    }
+        // Without an apron fall back to clamped (one-sided) differences
+        int rowDown = hasApron ? row - 1 : std::max(row - 1, 0);
+        int rowUp   = hasApron ? row + 1 : std::min(row + 1, last);
+        float dzDist = (rowUp - rowDown) * spacing;
 
-    // Normalize accumulated normals
-    #pragma omp parallel for
-    for(size_t i = 0; i < numVertices; ++i) {
-        float len = glm::length(tempNormals[i]);
-        if (len > 0.0f) {
-            out.vertices[i].normal = tempNormals[i] / len;
-        } else {
-            out.vertices[i].normal = glm::vec3(0.0f, 1.0f, 0.0f);  // Default up
+        std::vector<float> nx(cellsPerSide), ny(cellsPerSide), nz(cellsPerSide);
+
+        #pragma omp simd
+        for(int col = 0; col < cellsPerSide; ++col)
+        {
+            int colLeft  = hasApron ? col - 1 : std::max(col - 1, 0);
+            int colRight = hasApron ? col + 1 : std::min(col + 1, last);
+            float dxDist = (colRight - colLeft) * spacing;
+
+            // n = (-dh/dx, 1, -dh/dz), normalized
+            float gx = (grid.at(row, colLeft) - grid.at(row, colRight)) / dxDist;
+            float gz = (grid.at(rowDown, col) - grid.at(rowUp, col)) / dzDist;
+            float invLen = 1.0f / std::sqrt(gx * gx + 1.0f + gz * gz);
+
+            nx[col] = gx * invLen;
+            ny[col] = invLen;
+            nz[col] = gz * invLen;
+        }
+
+        for(int col = 0; col < cellsPerSide; ++col)
+        {
+            MeshData::encodeNormal(glm::vec3(nx[col], ny[col], nz[col]), out.vertices[size_t(row) * cellsPerSide + col].normal);
         }
     }
 
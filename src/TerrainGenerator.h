@@ -2,10 +2,40 @@
 #define TERRAIN_GENERATOR_H
 
 #include "MeshData.h"
-#include <random>
+#include "NoiseBackend.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 
 #define HIGH_LOD_CELLS 65
+
+// Quantized heights cover +-HEIGHT_QUANT_SPAN * heightScale; fractal noise
+// is normalized to about [-1, 1], the extra span leaves headroom
+#define HEIGHT_QUANT_SPAN 2.0f
+
+// Square grid of height samples over one chunk, row-major, optionally
+// surrounded by `apron` extra samples per side at the same spacing
+struct HeightGrid{
+	int cellsPerSide = 0;
+	int apron = 0;
+	std::vector<float> heights;  // stride() * stride() samples
+
+	int stride() const { return cellsPerSide + 2 * apron; }
+
+	// row/col are chunk-local; -apron..cellsPerSide-1+apron is valid
+	float at(int row, int col) const { return heights[size_t(row + apron) * stride() + size_t(col + apron)]; }
+	bool empty() const { return heights.empty(); }
+
+	// Every n-th sample so that the result has `cells` samples per side;
+	// empty if the grids do not nest
+	HeightGrid decimated(int cells) const;
+
+	// Heights of a chunk mesh generated by TerrainGenerator
+	static HeightGrid fromMesh(const MeshData& data);
+};
+
 class TerrainGenerator{
 public:
 	struct Params{
@@ -15,24 +45,90 @@ public:
 		float lacunarity = 2.0f;
 		float heightScale = 20.0f;
 		unsigned int seed = 1337;
+		// Seeded honours `seed` but evaluates scalar; SimdPerlin is about
+		// 2x faster through the SIMD kernels and ignores `seed`
+		NoiseType noise = NoiseType::Seeded;
 	};
 
-	TerrainGenerator() = default;
-	explicit TerrainGenerator(const Params& p);
+	// Immutable set of parameters plus everything derived from them.
+	// Every method is const and touches no shared mutable state, so any
+	// number of workers can evaluate the same snapshot concurrently.
+	class Snapshot{
+	public:
+		Snapshot(const Params& p, uint64_t version);
+
+		MeshData generateChunk(int chunkX, int chunkZ, int cellsPerSide, float worldScale) const;
+		float getHeightAt(float worldX, float worldZ) const;
+
+		// getHeightAt for `count` positions through the backend's batch path
+		void sampleHeights(const float* worldX, const float* worldZ, float* out, size_t count) const;
+
+		// One mesh per entry of cellsPerLod (finest first), all derived
+		// from a single noise pass over the finest grid. Returns nothing
+		// once *cancelled is set.
+		std::vector<MeshData> generateLodChain(int chunkX, int chunkZ, const std::vector<int>& cellsPerLod, float worldScale,
+			const std::atomic<bool>* cancelled = nullptr) const;
+
+		// Same from an existing finest grid (cellsPerLod.front() samples per
+		// side, with apron), e.g. one loaded from the cache; coarser LODs
+		// only evaluate their apron ring
+		std::vector<MeshData> buildLodChain(int chunkX, int chunkZ, const HeightGrid& finest, const std::vector<int>& cellsPerLod,
+			float worldScale, const std::atomic<bool>* cancelled = nullptr) const;
 
-	MeshData generateChunk(int chunkX, int chunkZ, int cellPerSide, float worldScale);
+		// Samples with a one-sample apron around the chunk. Remaining rows
+		// are skipped and the grid comes back empty once *cancelled is set.
+		HeightGrid generateHeights(int chunkX, int chunkZ, int cellsPerSide, float worldScale,
+			const std::atomic<bool>* cancelled = nullptr) const;
 
+		// Adds the missing apron ring to a grid without one (4 * (cells + 1)
+		// noise samples); grids that already have one are returned as is
+		HeightGrid completeApron(int chunkX, int chunkZ, const HeightGrid& interior, float worldScale) const;
+
+		// Vertices and normals for an existing height grid; no noise. Indices
+		// come from the shared GridIndexBuffer for the grid size
+		MeshData buildMesh(int chunkX, int chunkZ, const HeightGrid& grid, float worldScale) const;
+
+		// Same two for any square of `size` world units from (originX,
+		// originZ), e.g. a quadtree node covering many chunks; the chunk
+		// versions are this with one chunk's footprint
+		HeightGrid generateRegionHeights(float originX, float originZ, float size, int cellsPerSide,
+			const std::atomic<bool>* cancelled = nullptr) const;
+		MeshData buildRegionMesh(float originX, float originZ, float size, const HeightGrid& grid) const;
+
+		const Params& getParams() const { return params; }
+		uint64_t getVersion() const { return version; }
+		const NoiseBackend& getNoise() const { return *noise; }
+
+		// Height quantization range written into every MeshData
+		float heightMin() const;
+		float heightRange() const;
+
+	private:
+		const Params params;
+		const uint64_t version;
+		NoiseKernels::FractalParams fractal;
+		std::unique_ptr<const NoiseBackend> noise;  // tables built once from params.seed
+	};
+
+	using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+	TerrainGenerator();
+	explicit TerrainGenerator(const Params& p);
+
+	// Evaluate the currently published snapshot
+	MeshData generateChunk(int chunkX, int chunkZ, int cellPerSide, float worldScale) const;
 	float getHeightAt(float worldX, float worldZ) const;
 
+	// Publishes a new snapshot with a bumped version. Jobs already holding
+	// the previous snapshot finish with the old parameters.
 	void setParams(const Params& p);
-	const Params& getParams() const;
+	Params getParams() const;
 
-private:
-	Params params;
-	std::mt19937 rng;
-	std::uniform_real_distribution<float> dist;
+	SnapshotPtr snapshot() const;
+	uint64_t getVersion() const;
 
-	float fractalPerlin(float x, float z) const;
+private:
+	SnapshotPtr current;
 };
 
-#endif
\ No newline at end of file
+#endif
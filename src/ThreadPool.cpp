@@ -0,0 +1,164 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+    // Index of the worker owning the current thread, -1 outside the pool
+    thread_local int currentWorker = -1;
+    thread_local const ThreadPool* currentPool = nullptr;
+}
+
+ThreadPool::ThreadPool(unsigned int threadCount){
+    if(threadCount == 0){
+        unsigned int hw = std::thread::hardware_concurrency();
+        // Leave one core for the render thread
+        threadCount = hw > 1 ? hw - 1 : 1;
+    }
+
+    workers.reserve(threadCount);
+    for(unsigned int i = 0; i < threadCount; ++i){
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    threads.reserve(threadCount);
+    for(unsigned int i = 0; i < threadCount; ++i){
+        threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCv.notify_all();
+
+    // Running jobs finish, queued ones are dropped; their handles never
+    // become ready
+    for(auto& t : threads){
+        if(t.joinable()) t.join();
+    }
+    for(auto& w : workers){
+        w->tasks.clear();
+    }
+}
+
+void ThreadPool::push(Task task){
+    unsigned int index;
+    if(currentPool == this && currentWorker >= 0){
+        // Jobs spawned from a worker stay local for cache locality
+        index = static_cast<unsigned int>(currentWorker);
+    }
+    else{
+        index = nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    }
+
+    task.seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+    task.state->reranked.store(&rerankCount, std::memory_order_release);
+    task.key = task.priority();
+
+    // Count before publishing so a fast worker never drives the gauge negative
+    queuedCount.fetch_add(1, std::memory_order_relaxed);
+    {
+        Worker& w = *workers[index];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.tasks.push_back(std::move(task));
+        std::push_heap(w.tasks.begin(), w.tasks.end(), TaskOrder());
+    }
+
+    {
+        // Taking the lock avoids a lost wakeup between the idle check and wait()
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCv.notify_one();
+}
+
+bool ThreadPool::takeBest(Worker& w, Task& out){
+    if(w.tasks.empty()) return false;
+
+    // Startup queues the whole load window at once, so picks are heap pops.
+    // Re-ranking arrives in batches (once per terrain update), so the heap
+    // is rebuilt from fresh priorities at most once per batch.
+    uint64_t reranked = rerankCount.load(std::memory_order_acquire);
+    if(reranked != w.rankedAt){
+        for(Task& t : w.tasks) t.key = t.priority();
+        std::make_heap(w.tasks.begin(), w.tasks.end(), TaskOrder());
+        w.rankedAt = reranked;
+    }
+
+    std::pop_heap(w.tasks.begin(), w.tasks.end(), TaskOrder());
+    out = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::popLocal(unsigned int index, Task& out){
+    Worker& w = *workers[index];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    return takeBest(w, out);
+}
+
+bool ThreadPool::steal(unsigned int thief, Task& out){
+    const unsigned int n = static_cast<unsigned int>(workers.size());
+    for(unsigned int k = 1; k < n; ++k){
+        Worker& victim = *workers[(thief + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!takeBest(victim, out)) continue;
+
+        stolenCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned int index){
+    currentWorker = static_cast<int>(index);
+    currentPool = this;
+
+#ifdef _OPENMP
+    // The pool already provides the parallelism, so keep OpenMP regions
+    // inside jobs single-threaded instead of spawning a team per worker
+    omp_set_num_threads(1);
+#endif
+
+    for(;;){
+        if(stopping.load(std::memory_order_relaxed)) return;
+
+        Task task;
+        if(popLocal(index, task) || steal(index, task)){
+            queuedCount.fetch_sub(1, std::memory_order_relaxed);
+
+            if(task.token && task.token->cancelled()){
+                cancelledCount.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            runningCount.fetch_add(1, std::memory_order_relaxed);
+
+            task.run();
+
+            runningCount.fetch_sub(1, std::memory_order_relaxed);
+            completedCount.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCv.wait(lock, [this]() {
+            return stopping || queuedCount.load(std::memory_order_relaxed) > 0;
+        });
+        if(stopping) return;
+    }
+}
+
+ThreadPool::Stats ThreadPool::getStats() const{
+    Stats s;
+    s.queued = queuedCount.load(std::memory_order_relaxed);
+    s.running = runningCount.load(std::memory_order_relaxed);
+    s.stolen = stolenCount.load(std::memory_order_relaxed);
+    s.completed = completedCount.load(std::memory_order_relaxed);
+    s.cancelled = cancelledCount.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,203 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Shared state between a submitted job and the thread polling for it
+struct JobState {
+    std::atomic<bool> ready{false};
+    std::atomic<float> priority{0.0f};  // higher runs first, may change while queued
+    std::atomic<std::atomic<uint64_t>*> reranked{nullptr};  // pool counter bumped on a change, set once queued
+};
+
+template<typename T>
+struct JobResult : JobState {
+    T value{};
+};
+
+// Cooperative cancellation flag shared by the submitter and a job. The pool
+// drops cancelled jobs that have not started; running jobs poll cancelled()
+// (or pass flag() down) and return early.
+class CancelToken {
+public:
+    CancelToken() : state(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { state->store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return state->load(std::memory_order_relaxed); }
+    const std::atomic<bool>* flag() const { return state.get(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> state;
+};
+
+// Lightweight handle returned by ThreadPool::submit. Poll it from the main
+// thread and take() the value once it reports ready.
+template<typename T>
+class JobHandle {
+public:
+    JobHandle() = default;
+    explicit JobHandle(std::shared_ptr<JobResult<T>> s) : state(std::move(s)) {}
+
+    bool valid() const { return state != nullptr; }
+    bool poll() const { return state && state->ready.load(std::memory_order_acquire); }
+
+    // Re-rank a job that is still queued; no effect once it started
+    void setPriority(float p) {
+        if (!state || state->priority.exchange(p, std::memory_order_relaxed) == p) return;
+        std::atomic<uint64_t>* counter = state->reranked.load(std::memory_order_acquire);
+        if (counter) counter->fetch_add(1, std::memory_order_release);
+    }
+
+    // Only call after poll() returned true; invalidates the handle
+    T take() {
+        T value = std::move(state->value);
+        state.reset();
+        return value;
+    }
+
+private:
+    std::shared_ptr<JobResult<T>> state;
+};
+
+// Fixed-size worker pool with one priority queue per worker. Workers take
+// the highest-priority job from their own queue, or steal the highest-
+// priority one from another worker when theirs is empty; equal priorities
+// run in submission order. Callers can re-rank queued jobs through
+// JobHandle::setPriority; a queue re-reads its priorities before the next
+// pick after any change.
+class ThreadPool {
+public:
+    struct Stats {
+        uint64_t queued = 0;     // jobs waiting in any queue
+        uint64_t running = 0;    // jobs currently executing
+        uint64_t stolen = 0;     // total jobs taken from another worker's queue
+        uint64_t completed = 0;  // total jobs finished
+        uint64_t cancelled = 0;  // total jobs dropped before they started
+    };
+
+    // threadCount == 0 sizes the pool from std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<typename F>
+    auto submit(F&& fn, float priority = 0.0f) -> JobHandle<std::invoke_result_t<F&>>;
+
+    // Same, but the job is skipped if token is cancelled before it starts.
+    // The handle of a skipped job never becomes ready.
+    template<typename F>
+    auto submit(F&& fn, float priority, const CancelToken& token) -> JobHandle<std::invoke_result_t<F&>>;
+
+    // Runs fn into a result created up front, for handles given out before
+    // the job that produces their value is known (e.g. it depends on I/O).
+    // The job is queued at the state's current priority.
+    template<typename R, typename F>
+    void submitTo(const std::shared_ptr<JobResult<R>>& state, F&& fn, const CancelToken& token);
+
+    Stats getStats() const;
+    unsigned int size() const { return static_cast<unsigned int>(threads.size()); }
+
+private:
+    struct Task {
+        std::function<void()> run;
+        std::shared_ptr<JobState> state;
+        std::optional<CancelToken> token;
+        float key = 0.0f;   // priority as of the last heap build
+        uint64_t seq = 0;   // submission order, breaks ties
+
+        float priority() const { return state->priority.load(std::memory_order_relaxed); }
+    };
+
+    // Heap order: higher key first, then earlier submission
+    struct TaskOrder {
+        bool operator()(const Task& a, const Task& b) const {
+            return a.key < b.key || (a.key == b.key && a.seq > b.seq);
+        }
+    };
+
+    struct Worker {
+        std::vector<Task> tasks;  // max-heap by TaskOrder
+        uint64_t rankedAt = 0;    // rerankCount the keys were read at
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<bool> stopping{false};  // set under sleepMutex, polled between jobs
+
+    std::atomic<unsigned int> nextWorker{0};
+    std::atomic<uint64_t> nextSeq{0};
+    std::atomic<uint64_t> rerankCount{0};  // priority changes of queued jobs
+    std::atomic<uint64_t> queuedCount{0};
+    std::atomic<uint64_t> runningCount{0};
+    std::atomic<uint64_t> stolenCount{0};
+    std::atomic<uint64_t> completedCount{0};
+    std::atomic<uint64_t> cancelledCount{0};
+
+    template<typename F>
+    auto enqueue(F&& fn, float priority, const CancelToken* token) -> JobHandle<std::invoke_result_t<F&>>;
+
+    template<typename R, typename F>
+    void enqueueInto(const std::shared_ptr<JobResult<R>>& state, F&& fn, const CancelToken* token);
+
+    void push(Task task);
+    bool popLocal(unsigned int index, Task& out);
+    bool steal(unsigned int thief, Task& out);
+    bool takeBest(Worker& w, Task& out);
+    void workerLoop(unsigned int index);
+};
+
+template<typename F>
+auto ThreadPool::submit(F&& fn, float priority) -> JobHandle<std::invoke_result_t<F&>> {
+    return enqueue(std::forward<F>(fn), priority, nullptr);
+}
+
+template<typename F>
+auto ThreadPool::submit(F&& fn, float priority, const CancelToken& token) -> JobHandle<std::invoke_result_t<F&>> {
+    return enqueue(std::forward<F>(fn), priority, &token);
+}
+
+template<typename R, typename F>
+void ThreadPool::submitTo(const std::shared_ptr<JobResult<R>>& state, F&& fn, const CancelToken& token) {
+    static_assert(std::is_same_v<std::invoke_result_t<F&>, R>, "job must return the result type");
+    enqueueInto(state, std::forward<F>(fn), &token);
+}
+
+template<typename F>
+auto ThreadPool::enqueue(F&& fn, float priority, const CancelToken* token) -> JobHandle<std::invoke_result_t<F&>> {
+    using R = std::invoke_result_t<F&>;
+    auto state = std::make_shared<JobResult<R>>();
+    state->priority.store(priority, std::memory_order_relaxed);
+    enqueueInto(state, std::forward<F>(fn), token);
+    return JobHandle<R>(state);
+}
+
+template<typename R, typename F>
+void ThreadPool::enqueueInto(const std::shared_ptr<JobResult<R>>& state, F&& fn, const CancelToken* token) {
+    Task task;
+    task.state = state;
+    if(token){
+        task.token = *token;
+    }
+    task.run = [state, f = std::forward<F>(fn)]() mutable {
+        state->value = f();
+        state->ready.store(true, std::memory_order_release);
+    };
+    push(std::move(task));
+}
+
+#endif
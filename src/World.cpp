@@ -1,7 +1,8 @@
 #include "World.h"
+#include "GridIndexBuffer.h"
 #include <iostream>
 
-World::World() {
+World::World(TerrainMode mode_, const LodChain& lods) : mode(mode_) {
 
     TextureManager::loadTexture("grass", "assets/textures/grass.jpg");
     TextureManager::loadTexture("rock",  "assets/textures/rock.jpg");
@@ -27,7 +28,16 @@ World::World() {
     params.seed = 42;
     generator = TerrainGenerator(params);
 
-    terrain = new Terrain(7, 7, 65, 1.0, generator);
+    if (mode == TerrainMode::Quadtree) {
+        quadtree = new QuadtreeTerrain(generator, jobPool, 1.0f);
+    }
+    else if (mode == TerrainMode::Clipmap) {
+        clipmapShader = new Shader("shaders/clipmap.vert", "shaders/terrain.frag");
+        clipmap = new ClipmapTerrain(generator, 1.0f);
+    }
+    else {
+        terrain = new Terrain(7, 7, 65, 1.0, generator, jobPool, camera->getPosition(), lods);
+    }
 
     elapsedTime = 0.0f;
     growthTimer = 0.0f;
@@ -35,6 +45,20 @@ World::World() {
 }
 
 
+World::~World() {
+    delete clipmap;
+    delete quadtree;
+    delete terrain;
+
+    // Shared by every terrain mode's meshes, so only once they are all gone
+    GridIndexBuffer::releaseAll();
+
+    delete clipmapShader;
+    delete terrainShader;
+    delete skyShader;
+    delete skybox;
+    delete camera;
+}
 
 void World::render(float dt) {
     glClearColor(0.529f, 0.808f, 0.922f, 1.0f); // light sky blue
@@ -57,7 +81,15 @@ void World::render(float dt) {
 
     Frustum f = extractFrustum(projection * view);
 
-    terrain->draw(f, camera->getPosition(), false);
+    if (clipmap) {
+        clipmapShader->use();
+        clipmapShader->setMat4("model", model);
+        clipmapShader->setMat4("view", view);
+        clipmapShader->setMat4("projection", projection);
+        clipmap->draw(*clipmapShader, f, false);
+    }
+    else if (quadtree) quadtree->draw(*terrainShader, f, camera->getPosition(), false);
+    else terrain->draw(*terrainShader, f, false);
 
     skybox->draw(view, projection, false);
 
@@ -66,7 +98,9 @@ void World::render(float dt) {
 void World::update(float deltaTime) {
     elapsedTime += deltaTime;
     
-    terrain->update(deltaTime, camera->getPosition());
+    if (clipmap) clipmap->update(deltaTime, *camera);
+    else if (quadtree) quadtree->update(deltaTime, *camera);
+    else terrain->update(deltaTime, *camera);
 }
 
 void World::handleInput(int input, glm::vec2 mousePos, float dt) {
@@ -5,24 +5,37 @@
 #include "Camera.h"
 #include "SkyBox.h"
 #include "Terrain.h"
+#include "QuadtreeTerrain.h"
+#include "ClipmapTerrain.h"
 #include "TextureManager.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 
+enum class TerrainMode {
+    Chunks,     // Terrain: uniform chunks, each with an LOD chain
+    Quadtree,   // QuadtreeTerrain: nodes doubling in size with distance
+    Clipmap     // ClipmapTerrain: camera-centred rings over toroidal heightmaps
+};
+
 class World {
 private:
     
     // Shaders
     Shader* skyShader;
     Shader* terrainShader;
+    Shader* clipmapShader = nullptr;
 
     // Scene objects
     Camera* camera;
     SkyBox* skybox;
-    Terrain* terrain;
+    TerrainMode mode;
+    Terrain* terrain = nullptr;
+    QuadtreeTerrain* quadtree = nullptr;
+    ClipmapTerrain* clipmap = nullptr;
     
     // Terrain generation
     TerrainGenerator generator;
+    ThreadPool jobPool;
 
     // Time tracking
     float elapsedTime;
@@ -31,7 +44,8 @@ private:
 
 
 public:
-    World();
+    // lods: chunk LOD levels and view distance, chunk mode only
+    explicit World(TerrainMode mode = TerrainMode::Chunks, const LodChain& lods = LodChain());
     ~World();
 
     // Main loop methods
@@ -41,6 +55,11 @@ public:
 
     // Accessors
     Camera* getCamera() const { return camera; }
+    ThreadPool::Stats getJobStats() const { return jobPool.getStats(); }
+    TerrainMode getMode() const { return mode; }
+    const TerrainStats& getTerrainStats() const { return terrain->getStats(); }
+    const QuadtreeTerrain::Stats& getQuadtreeStats() const { return quadtree->getStats(); }
+    const ClipmapTerrain::Stats& getClipmapStats() const { return clipmap->getStats(); }
 };
 
 // Utility function
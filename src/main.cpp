@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <cmath>
+#include <string>
 #include <vector>
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -19,7 +20,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
 
 std::vector<int> getInputs(GLFWwindow* window);
 
-int main(){
+int main(int argc, char** argv){
 
     //Simulation s = Simulation();
 
@@ -66,7 +67,18 @@ int main(){
         return -1;
     }
 
-    World* w = new World();
+    // --quadtree switches to the CDLOD quadtree terrain, --clipmap to the
+    // geometry clipmap; --lods cells:distance,... sets the chunk LOD chain
+    TerrainMode mode = TerrainMode::Chunks;
+    LodChain lods;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quadtree") mode = TerrainMode::Quadtree;
+        else if (arg == "--clipmap") mode = TerrainMode::Clipmap;
+        else if (arg == "--lods" && i + 1 < argc) lods = LodChain::parse(argv[++i]);
+    }
+
+    World* w = new World(mode, lods);
 
     // Setup ImGui context
     IMGUI_CHECKVERSION();
@@ -184,6 +196,75 @@ int main(){
         ImGui::Begin("FPS Overlay", nullptr, window_flags);
         ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
         ImGui::Text("Frame: %.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+
+        ThreadPool::Stats jobs = w->getJobStats();
+        ImGui::Text("Jobs: %llu queued, %llu running", (unsigned long long)jobs.queued, (unsigned long long)jobs.running);
+        ImGui::Text("Jobs: %llu stolen, %llu completed", (unsigned long long)jobs.stolen, (unsigned long long)jobs.completed);
+
+        if (w->getMode() == TerrainMode::Clipmap) {
+            const ClipmapTerrain::Stats& cs = w->getClipmapStats();
+            ImGui::Text("Clipmap: %d levels of %d^2, %zu draw calls, view %.0f units",
+                cs.levels, cs.gridSize, cs.drawCalls, cs.viewDistance);
+            ImGui::Text("Heightmaps: %.2f MiB, %zu texels uploaded last frame (%.0f us)",
+                cs.textureBytes / (1024.0f * 1024.0f), cs.texelsUploadedLastFrame, cs.updateMicros);
+            ImGui::Text("Updates: %llu strips, %llu full; %llu samples generated",
+                (unsigned long long)cs.stripUpdates, (unsigned long long)cs.fullRefreshes,
+                (unsigned long long)cs.samplesGenerated);
+        }
+        else if (w->getMode() == TerrainMode::Quadtree) {
+            const QuadtreeTerrain::Stats& qs = w->getQuadtreeStats();
+            ImGui::Text("Quadtree: %zu nodes drawn, %zu subtrees culled, view %.0f units",
+                qs.drawnNodes, qs.culledSubtrees, qs.viewDistance);
+            ImGui::Text("Nodes: %zu resident (%.1f MiB), %zu pending, %llu generated, %llu evicted",
+                qs.residentNodes, qs.gpuBytes / (1024.0f * 1024.0f), qs.pendingNodes,
+                (unsigned long long)qs.generatedNodes, (unsigned long long)qs.evictedNodes);
+            ImGui::Text("Noise samples: %llu", (unsigned long long)qs.noiseSamples);
+            for (size_t level = 0; level < qs.drawnPerLevel.size(); ++level) {
+                if (qs.drawnPerLevel[level] > 0) ImGui::Text("  Level %zu: %u drawn", level, qs.drawnPerLevel[level]);
+            }
+        }
+        else {
+            const TerrainStats& terrainStats = w->getTerrainStats();
+            ImGui::Text("Noise samples: %llu", (unsigned long long)terrainStats.noiseSamples);
+            ImGui::Text("Derived LODs: %llu", (unsigned long long)terrainStats.derivedLods);
+            ImGui::Text("Cancelled: %llu requests, %llu dropped unstarted, %llu samples avoided (max)",
+                (unsigned long long)terrainStats.cancelledJobs, (unsigned long long)jobs.cancelled,
+                (unsigned long long)terrainStats.cancelledSamples);
+            ImGui::Text("Prefetch: %llu requested, %llu promoted, %llu early, lookahead %.2fs, latency %.0f ms",
+                (unsigned long long)terrainStats.prefetchRequests, (unsigned long long)terrainStats.prefetchPromoted,
+                (unsigned long long)terrainStats.prefetchCompleted, terrainStats.prefetchLookahead,
+                terrainStats.jobLatency * 1000.0f);
+            ImGui::Text("Startup: first frame %.0f ms, full detail %.0f ms",
+                terrainStats.timeToFirstFrame * 1000.0f, terrainStats.timeToFullDetail * 1000.0f);
+            ImGui::Text("Cache: %llu chunk hits, %llu samples saved, %llu lookups missed, %llu written (%.1f MiB)",
+                (unsigned long long)terrainStats.cacheHits, (unsigned long long)terrainStats.cacheSamplesSaved,
+                (unsigned long long)terrainStats.cacheIO.misses, (unsigned long long)terrainStats.cacheIO.writes,
+                terrainStats.cacheIO.bytesWritten / (1024.0f * 1024.0f));
+            ImGui::Text("Cold tier: %zu chunks, %.1f / %.0f MiB, %llu re-meshed, %llu evicted",
+                terrainStats.cold.entries, terrainStats.cold.bytes / (1024.0f * 1024.0f),
+                terrainStats.cold.budget / (1024.0f * 1024.0f), (unsigned long long)terrainStats.coldHits,
+                (unsigned long long)terrainStats.cold.evicted);
+            ImGui::Text("LOD churn: %llu switches, %llu reversals, %llu coarsenings held, %llu quick reloads",
+                (unsigned long long)terrainStats.lodSwitches, (unsigned long long)terrainStats.lodReversals,
+                (unsigned long long)terrainStats.lodDeferrals, (unsigned long long)terrainStats.quickReloads);
+            const MeshMemoryBudget::Usage& mem = terrainStats.meshMemory;
+            ImGui::Text("Mesh memory: CPU %.1f / %.0f MiB, GPU %.1f / %.0f MiB, %llu LODs evicted, %llu CPU copies released",
+                mem.cpuTotal() / (1024.0f * 1024.0f), mem.cpuBudget / (1024.0f * 1024.0f),
+                mem.gpuTotal() / (1024.0f * 1024.0f), mem.gpuBudget / (1024.0f * 1024.0f),
+                (unsigned long long)terrainStats.evictedLods, (unsigned long long)terrainStats.releasedCpuCopies);
+            for (size_t lod = 0; lod < mem.gpuMeshes.size(); ++lod) {
+                ImGui::Text("  LOD %zu: %u meshes %.1f MiB, %u CPU copies %.1f MiB", lod,
+                    mem.gpuMeshes[lod], mem.gpuBytes[lod] / (1024.0f * 1024.0f),
+                    mem.cpuCopies[lod], mem.cpuBytes[lod] / (1024.0f * 1024.0f));
+            }
+            ImGui::Text("Cache I/O: %s, %llu batches, %llu in flight, %llu read ahead (%llu used)",
+                terrainStats.cacheBackend, (unsigned long long)terrainStats.cacheIO.batches,
+                (unsigned long long)terrainStats.cacheIO.inFlight, (unsigned long long)terrainStats.cacheIO.readAheads,
+                (unsigned long long)terrainStats.cacheIO.readAheadHits);
+            ImGui::Text("Uploads: %llu meshes, %zu queued, %.1f KiB / %.0f us last frame, %.0f us peak",
+                (unsigned long long)terrainStats.uploadedMeshes, terrainStats.uploadQueued,
+                terrainStats.uploadBytes / 1024.0f, terrainStats.uploadMicros, terrainStats.uploadMicrosPeak);
+        }
         ImGui::End();
 
         w->render(deltaTime);
@@ -198,6 +279,9 @@ int main(){
     }
 
 
+    // GL resources go while the context is still current
+    delete w;
+
     // Cleanup ImGui
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -0,0 +1,69 @@
+// Offline maintenance for the terrain cache region files.
+//
+//   region_tool stats   <cache dir>   live vs. file bytes per region
+//   region_tool compact <cache dir>   rewrite regions with only live payloads
+//
+// Rewritten chunks leave their old payload behind (regions are append-only
+// while the game runs), so compaction reclaims that space. Run it while
+// the game is not running.
+
+#include "RegionFile.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv){
+    if(argc < 3 || (std::strcmp(argv[1], "stats") != 0 && std::strcmp(argv[1], "compact") != 0)){
+        std::fprintf(stderr, "usage: %s stats|compact <cache dir>\n", argv[0]);
+        return 2;
+    }
+    const bool compact = std::strcmp(argv[1], "compact") == 0;
+
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for(fs::recursive_directory_iterator it(argv[2], ec), end; !ec && it != end; it.increment(ec)){
+        if(it->is_regular_file() && it->path().extension() == ".region"){
+            files.push_back(it->path());
+        }
+    }
+    if(ec){
+        std::fprintf(stderr, "cannot read %s: %s\n", argv[2], ec.message().c_str());
+        return 1;
+    }
+
+    uint64_t totalBefore = 0, totalAfter = 0;
+    int failed = 0;
+    for(const fs::path& path : files){
+        RegionFile::Usage before, after;
+        bool ok;
+        if(compact){
+            ok = RegionFile::compact(path.string(), &before, &after);
+        }
+        else{
+            ok = RegionFile::inspect(path.string(), before);
+            after = before;
+            after.fileBytes = before.liveBytes;
+        }
+
+        if(!ok){
+            std::fprintf(stderr, "%s: not a valid region file\n", path.string().c_str());
+            ++failed;
+            continue;
+        }
+
+        std::printf("%s: %u chunk grids, %.1f KiB file, %.1f KiB live", path.string().c_str(), before.entries,
+            before.fileBytes / 1024.0, before.liveBytes / 1024.0);
+        if(compact) std::printf(", now %.1f KiB", after.fileBytes / 1024.0);
+        std::printf("\n");
+        totalBefore += before.fileBytes;
+        totalAfter += after.fileBytes;
+    }
+
+    std::printf("%zu regions, %.1f MiB %s %.1f MiB\n", files.size(), totalBefore / (1024.0 * 1024.0),
+        compact ? "->" : "reclaimable to", totalAfter / (1024.0 * 1024.0));
+    return failed > 0 ? 1 : 0;
+}